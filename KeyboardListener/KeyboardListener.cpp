@@ -1,22 +1,102 @@
 ﻿#include "pch.h"
 #include "resource.h"
-#include "utils/PairHash.h"
-
-#include <array>
-#include <unordered_set>
-#include <unordered_map>
+#include "utils/HotkeyTable.h"
+#include "utils/LatencyHistogram.h"
+#include "utils/SpscRing.h"
 
 #define DLLEXPORT extern "C" __declspec(dllexport)
 
-using HotkeyPair = std::pair<char, UINT>;
-using NotifyPair = std::pair<HWND, int>;
+// hotkey table shared by every process loading the hook, zero filled when created and
+// opened by openHotkeyTable(). slots are published by interlocked writes of target, so
+// the hook never takes a lock
+static const wchar_t *kHotkeyTableName = L"Local\\GroupTabBoxHotkeyTable";
+static HANDLE gTableMapping = nullptr;
+static HotkeyTable *gTable = nullptr;
+
+// ids of pressed hotkeys, the low level hook runs on the thread that installed it and
+// the notified window drains them after the hook has returned
+static SpscRing<HotkeyEvent, 64> gHotkeyEvents;
+
+// time spent in the hook per key, read by the application in the same process
+static LatencyHistogram gHookTime;
+
+// heartbeat for the watchdog of the application. a low level hook runs on the thread
+// that installed it, the watchdog reads it on that thread too
+static uint64_t gHookCalls = 0;
+static uint64_t gLastHookTime = 0;
+static uint32_t gRecentHookTimes[HookHealth::kRecentCount] = {};
+
+// same clock as the application, so events are timestamped where they arrive
+static uint64_t currentMicroseconds()
+{
+    static LARGE_INTEGER frequency = {};
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    const uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+    const uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000 + remainder * 1000000 / frequency.QuadPart;
+}
+
+// beats the heartbeat and records the time from construction to every return of the hook
+class HookTimer
+{
+public:
+    HookTimer() : m_start(currentMicroseconds())
+    {
+        ++gHookCalls;
+        gLastHookTime = m_start;
+    }
+    ~HookTimer()
+    {
+        const uint64_t elapsed = currentMicroseconds() - m_start;
+        gHookTime.record(elapsed);
+        gRecentHookTimes[gHookCalls % HookHealth::kRecentCount] = static_cast<uint32_t>(elapsed);
+    }
+
+    uint64_t start() const { return m_start; }
 
-// shared memory
-#pragma data_seg(".shared")
-std::unordered_map<HotkeyPair, NotifyPair> gHotkeys = {};
-std::array<std::unordered_set<HWND>, 5> gModUpNotify = {};
-#pragma data_seg()
-#pragma comment(linker, "/section:.shared,RWS")
+private:
+    uint64_t m_start;
+};
+
+static inline volatile LONG64 *targetOf(uint64_t *target)
+{
+    return reinterpret_cast<volatile LONG64 *>(target);
+}
+
+// the mapping may not be created in DllMain, which runs under the loader lock
+DLLEXPORT bool openHotkeyTable()
+{
+    if (gTable)
+        return true;
+
+    gTableMapping = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            0, sizeof(HotkeyTable), kHotkeyTableName);
+    if (!gTableMapping)
+        return false;
+
+    gTable = static_cast<HotkeyTable *>(
+            MapViewOfFile(gTableMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(HotkeyTable)));
+    if (!gTable) {
+        CloseHandle(gTableMapping);
+        gTableMapping = nullptr;
+        return false;
+    }
+    return true;
+}
+
+DLLEXPORT void closeHotkeyTable()
+{
+    if (gTable)
+        UnmapViewOfFile(gTable);
+    if (gTableMapping)
+        CloseHandle(gTableMapping);
+    gTable = nullptr;
+    gTableMapping = nullptr;
+}
 
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD  ul_reason_for_call, LPVOID lpReserved)
 {
@@ -33,28 +113,77 @@ static inline char toModifierBit(UINT key)
 DLLEXPORT bool addHotkey(HWND hwnd, int id, UINT modifiers, UINT key)
 {
     // SHIFT | CTRL | ALT (lower 3 bits)
-    HotkeyPair hotkey(modifiers, key);
-    auto it = gHotkeys.find(hotkey);
-    if (it != gHotkeys.end())
+    if (!gTable || !hwnd || !HotkeyTable::validHotkey(modifiers, key))
         return false;
-    gHotkeys.emplace(hotkey, NotifyPair(hwnd, id));
+
+    // claim the slot before writing its id, so two registrations never share a slot
+    HotkeySlot &slot = gTable->hotkeys[modifiers][key];
+    const LONG64 claimed = static_cast<LONG64>(HotkeyTable::kClaimedTarget);
+    if (InterlockedCompareExchange64(targetOf(&slot.target), claimed, 0) != 0)
+        return false;
+    // the hook skips a claimed slot, it reads the id only after the window is published
+    slot.id = id;
+    InterlockedExchange64(targetOf(&slot.target), reinterpret_cast<LONG64>(hwnd));
     return true;
 }
 
+DLLEXPORT bool removeHotkey(HWND hwnd, UINT modifiers, UINT key)
+{
+    if (!gTable || !hwnd || !HotkeyTable::validHotkey(modifiers, key))
+        return false;
+
+    // only the window that added the hotkey frees its slot
+    HotkeySlot &slot = gTable->hotkeys[modifiers][key];
+    const LONG64 target = reinterpret_cast<LONG64>(hwnd);
+    return InterlockedCompareExchange64(targetOf(&slot.target), 0, target) == target;
+}
+
 DLLEXPORT bool modUpNotifyOnce(HWND hwnd, UINT modifiers)
 {
     // only support single modifier
-    if (modifiers != MOD_ALT && modifiers != MOD_CONTROL && modifiers != MOD_SHIFT)
+    if (!gTable || !hwnd || !HotkeyTable::validModifier(modifiers))
         return false;
-    gModUpNotify[modifiers].emplace(hwnd);
-    return true;
+
+    const LONG64 target = reinterpret_cast<LONG64>(hwnd);
+    uint64_t *targets = gTable->mod_up_targets[modifiers];
+    for (size_t i = 0; i < HotkeyTable::kModUpTargetCount; ++i) {
+        const LONG64 current = InterlockedCompareExchange64(targetOf(&targets[i]), target, 0);
+        if (current == 0 || current == target)
+            return true;
+    }
+    return false;
+}
+
+DLLEXPORT bool popHotkey(HotkeyEvent *event)
+{
+    return event && gHotkeyEvents.pop(event);
+}
+
+DLLEXPORT const LatencyHistogram *hookTime()
+{
+    return &gHookTime;
+}
+
+DLLEXPORT void hookHealth(HookHealth *health)
+{
+    if (!health)
+        return;
+
+    health->calls = gHookCalls;
+    health->last_call_time = gLastHookTime;
+    // the oldest sample follows the latest one
+    for (size_t i = 0; i < HookHealth::kRecentCount; ++i) {
+        health->recent_times[i] =
+                gRecentHookTimes[(gHookCalls + 1 + i) % HookHealth::kRecentCount];
+    }
 }
 
 DLLEXPORT LRESULT CALLBACK keyboardHookProc(int code, WPARAM wParam, LPARAM lParam)
 {
     static char mod_state = 0;
+    const HookTimer timer;
 
-    if (code < 0)
+    if (code < 0 || !gTable)
         return CallNextHookEx(nullptr, code, wParam, lParam);
 
     KBDLLHOOKSTRUCT *key_info = reinterpret_cast<KBDLLHOOKSTRUCT *>(lParam);
@@ -64,24 +193,33 @@ DLLEXPORT LRESULT CALLBACK keyboardHookProc(int code, WPARAM wParam, LPARAM lPar
         // modifier key up
         if (mod != 0) {
             mod_state &= ~mod;
-            // notify mod up
-            if (!gModUpNotify[mod].empty()) {
-                for (const auto &hwnd : gModUpNotify[mod])
-                    SendMessage(hwnd, WMAPP_MODUP, mod, 0);
-                gModUpNotify[mod].clear();
+            // notify mod up, posted so a busy render thread does not block the hook
+            uint64_t *targets = gTable->mod_up_targets[mod];
+            for (size_t i = 0; i < HotkeyTable::kModUpTargetCount; ++i) {
+                const LONG64 target = InterlockedExchange64(targetOf(&targets[i]), 0);
+                if (target != 0)
+                    PostMessage(reinterpret_cast<HWND>(target), WMAPP_MODUP, mod, 0);
             }
         }
     } else {
         if (mod != 0) {
             // modifier key down
             mod_state |= mod;
-        } else {
+        } else if (key_info->vkCode < HotkeyTable::kKeyCount) {
             // normal key down
-            HotkeyPair hotkey(mod_state, key_info->vkCode);
-            auto it = gHotkeys.find(hotkey);
-            if (it != gHotkeys.end()) {
-                SendMessage(it->second.first, WMAPP_HOTKEY, it->second.second, 0);
-                return 1;
+            HotkeySlot &slot = gTable->hotkeys[mod_state][key_info->vkCode];
+            const LONG64 target = *targetOf(&slot.target);
+            if (target != 0 && target != static_cast<LONG64>(HotkeyTable::kClaimedTarget)) {
+                // never wait for the window, only the first hotkey of a batch wakes it
+                bool was_empty = false;
+                const HotkeyEvent event = { slot.id, timer.start() };
+                if (gHotkeyEvents.push(event, &was_empty)) {
+                    if (was_empty)
+                        PostMessage(reinterpret_cast<HWND>(target), WMAPP_HOTKEY, 0, 0);
+                    return 1;
+                }
+                // the ring is full and the app takes no hotkeys, pass the key on
+                // instead of swallowing a hotkey that never runs
             }
         }
     }
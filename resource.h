@@ -14,6 +14,11 @@
 const UINT WMAPP_TRAYCALLBACK = WM_APP + 1;
 const UINT WMAPP_HOTKEY = WM_APP + 2;
 const UINT WMAPP_MODUP = WM_APP + 3;
+const UINT WMAPP_FRAME = WM_APP + 4;
+const UINT WMAPP_RENDER = WM_APP + 5;
+const UINT WMAPP_CONFIGCHANGED = WM_APP + 6;
 
 const UINT kTrayIconID = 114;
 const UINT kTrayMenuExitID = 514;
+const UINT kTrayMenuStatisticsID = 515;
+const UINT kTrayMenuExportStatisticsID = 516;
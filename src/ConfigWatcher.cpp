@@ -0,0 +1,119 @@
+#include "ConfigWatcher.h"
+#include "GlobalData.h"
+#include "MainWindow.h"
+#include "Metrics.h"
+#include "RenderThread.h"
+#include "resource.h"
+#include "utils/ProgramUtils.h"
+
+ConfigWatcher::~ConfigWatcher()
+{
+    stop();
+}
+
+bool ConfigWatcher::start(HWND hwnd)
+{
+    if (m_thread.joinable())
+        return true;
+    if (!hwnd)
+        return false;
+
+    m_stop_event = { CreateEvent(nullptr, TRUE, FALSE, nullptr), CloseHandle };
+    if (!m_stop_event)
+        return false;
+
+    // renaming covers editors that save into a new file and replace the old one
+    const HANDLE change = FindFirstChangeNotification(programDir().c_str(), FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (change == INVALID_HANDLE_VALUE)
+        return false;
+    m_change = { change, FindCloseChangeNotification };
+
+    m_hwnd = hwnd;
+    m_settings = config()->settings();
+    m_problems = config()->diagnosticsText();
+    fileChanged();
+    m_thread = std::thread(&ConfigWatcher::run, this);
+    return true;
+}
+
+void ConfigWatcher::stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    SetEvent(m_stop_event.get());
+    m_thread.join();
+}
+
+void ConfigWatcher::reload()
+{
+    const uint64_t start_time = currentMicroseconds();
+
+    Configure::Settings settings;
+    std::vector<IniDiagnostic> diagnostics;
+    // replaced while it is read, the next change reloads it
+    if (!Configure::read(&settings, &diagnostics))
+        return;
+
+    const unsigned int changes = Configure::compare(m_settings, settings);
+    std::wstring problems = Configure::diagnosticsText(diagnostics);
+    if (changes != Configure::ChangeNone) {
+        if ((changes & Configure::ChangeHotkeys)
+                && !globalData()->mainWindow()->updateHotkeys(m_settings, settings))
+            problems += L"Some hotkeys are used by another program and are not registered\n";
+        if (changes & Configure::ChangeAutoStart)
+            setAutoStart(L"GroupTabBox", settings.auto_start);
+        if (changes & Configure::ChangeRestart)
+            problems += L"bRunAsAdmin and bSingleLayeredWindow take effect after restart\n";
+        m_settings = settings;
+
+        globalData()->renderThread()->post([settings, diagnostics, changes, start_time]() {
+            config()->apply(settings, diagnostics);
+            globalData()->refreshSettings(changes);
+            metrics()->configReload().record(currentMicroseconds() - start_time);
+        });
+    }
+
+    // once per distinct text while the file is edited, the modal loop may reload again
+    if (problems == m_problems)
+        return;
+    m_problems = problems;
+    if (!problems.empty())
+        MessageBox(m_hwnd, problems.c_str(), L"GroupTabBox Settings", MB_OK | MB_ICONWARNING);
+}
+
+void ConfigWatcher::run()
+{
+    const HANDLE handles[] = { m_stop_event.get(), m_change.get() };
+    bool pending = false;
+    while (true) {
+        const DWORD result = WaitForMultipleObjects(2, handles, FALSE,
+                pending ? kSettleDelay : INFINITE);
+        if (result == WAIT_OBJECT_0 + 1) {
+            pending |= fileChanged();
+            if (!FindNextChangeNotification(m_change.get()))
+                break;
+        } else if (result == WAIT_TIMEOUT) {
+            // no more writes within the settle delay
+            pending = false;
+            PostMessage(m_hwnd, WMAPP_CONFIGCHANGED, 0, 0);
+        } else {
+            break;
+        }
+    }
+}
+
+bool ConfigWatcher::fileChanged()
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    // missing while an editor replaces it
+    if (!GetFileAttributesEx(Configure::filePath().c_str(), GetFileExInfoStandard, &data))
+        return false;
+
+    const bool changed = CompareFileTime(&data.ftLastWriteTime, &m_file_data.ftLastWriteTime) != 0
+            || data.nFileSizeHigh != m_file_data.nFileSizeHigh
+            || data.nFileSizeLow != m_file_data.nFileSizeLow;
+    m_file_data = data;
+    return changed;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Configure.h"
+
+#include <Windows.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+// reloads the ini file after it is saved. a thread waits for changes in the program directory
+// and notifies the message thread, which registers changed hotkeys itself and hands the
+// other changes to the render thread. only what differs is refreshed, caches stay warm
+class ConfigWatcher
+{
+public:
+    static constexpr DWORD kSettleDelay = 100;  // milliseconds, editors save in several writes
+
+    ~ConfigWatcher();
+
+    // hwnd is notified by WMAPP_CONFIGCHANGED, settings of the last load are the base
+    bool start(HWND hwnd);
+    void stop();
+    // WMAPP_CONFIGCHANGED of hwnd, on message thread
+    void reload();
+
+private:
+    void run();
+    // compared by last write time and size, other files of the directory change too
+    bool fileChanged();
+
+    HWND m_hwnd = nullptr;
+    std::thread m_thread;
+    std::unique_ptr<void, decltype(&CloseHandle)> m_stop_event = { nullptr, CloseHandle };
+    std::unique_ptr<void, decltype(&FindCloseChangeNotification)> m_change = {
+        nullptr, FindCloseChangeNotification
+    };
+    WIN32_FILE_ATTRIBUTE_DATA m_file_data = {};  // watcher thread only
+
+    // message thread only, the render thread reads config()
+    Configure::Settings m_settings = {};  // applied last
+    std::wstring m_problems;  // shown last
+};
@@ -1,236 +1,258 @@
 #include "Configure.h"
 #include "utils/ProgramUtils.h"
 
-#include <array>
-#include <fstream>
-#include <regex>
-#include <unordered_map>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
 
-using SettingPair = std::pair<std::string, std::string>;
+const wchar_t *kConfigFile = L"GroupTabBox.ini";
 
-const char *kConfigFile = "GroupTabBox.ini";
+static_assert(std::is_standard_layout<Configure::Settings>::value,
+        "settings are written at offsets of the schema");
+static_assert(std::is_same<Configure::HotkeyPair, IniHotkey>::value,
+        "hotkeys are written as IniHotkey");
 
-const std::unordered_map<std::string, UINT> kModifierMap = {
+constexpr IniName kModifierNames[] = {
     { "SHIFT", MOD_SHIFT }, { "CTRL", MOD_CONTROL }, { "ALT", MOD_ALT }
 };
-const std::unordered_map<std::string, UINT> kKeyMap = {
+
+// letters and digits are written as themselves, mouse buttons never reach the keyboard hook
+constexpr IniName kKeyNames[] = {
     { "F1", VK_F1 }, { "F2", VK_F2 }, { "F3", VK_F3 }, { "F4", VK_F4 },
     { "F5", VK_F5 }, { "F6", VK_F6 }, { "F7", VK_F7 }, { "F8", VK_F8 },
     { "F9", VK_F9 }, { "F10", VK_F10 }, { "F11", VK_F11 }, { "F12", VK_F12 },
-    { "`", VK_OEM_3 }, { "TAB", VK_TAB }
+    { "F13", VK_F13 }, { "F14", VK_F14 }, { "F15", VK_F15 }, { "F16", VK_F16 },
+    { "F17", VK_F17 }, { "F18", VK_F18 }, { "F19", VK_F19 }, { "F20", VK_F20 },
+    { "F21", VK_F21 }, { "F22", VK_F22 }, { "F23", VK_F23 }, { "F24", VK_F24 },
+    { "`", VK_OEM_3 }, { "TAB", VK_TAB },
+    // editing and navigation
+    { "BACKSPACE", VK_BACK }, { "ENTER", VK_RETURN }, { "ESC", VK_ESCAPE }, { "SPACE", VK_SPACE },
+    { "PAGEUP", VK_PRIOR }, { "PAGEDOWN", VK_NEXT }, { "END", VK_END }, { "HOME", VK_HOME },
+    { "LEFT", VK_LEFT }, { "UP", VK_UP }, { "RIGHT", VK_RIGHT }, { "DOWN", VK_DOWN },
+    { "INSERT", VK_INSERT }, { "DELETE", VK_DELETE }, { "CLEAR", VK_CLEAR },
+    { "SELECT", VK_SELECT }, { "PRINT", VK_PRINT }, { "EXECUTE", VK_EXECUTE },
+    { "PRINTSCREEN", VK_SNAPSHOT }, { "HELP", VK_HELP }, { "PAUSE", VK_PAUSE },
+    { "BREAK", VK_CANCEL }, { "APPS", VK_APPS }, { "SLEEP", VK_SLEEP },
+    // locks and modifiers as keys
+    { "CAPSLOCK", VK_CAPITAL }, { "NUMLOCK", VK_NUMLOCK }, { "SCROLLLOCK", VK_SCROLL },
+    { "LWIN", VK_LWIN }, { "RWIN", VK_RWIN },
+    { "LSHIFT", VK_LSHIFT }, { "RSHIFT", VK_RSHIFT }, { "LCTRL", VK_LCONTROL },
+    { "RCTRL", VK_RCONTROL }, { "LALT", VK_LMENU }, { "RALT", VK_RMENU },
+    // numeric keypad
+    { "NUMPAD0", VK_NUMPAD0 }, { "NUMPAD1", VK_NUMPAD1 }, { "NUMPAD2", VK_NUMPAD2 },
+    { "NUMPAD3", VK_NUMPAD3 }, { "NUMPAD4", VK_NUMPAD4 }, { "NUMPAD5", VK_NUMPAD5 },
+    { "NUMPAD6", VK_NUMPAD6 }, { "NUMPAD7", VK_NUMPAD7 }, { "NUMPAD8", VK_NUMPAD8 },
+    { "NUMPAD9", VK_NUMPAD9 }, { "MULTIPLY", VK_MULTIPLY }, { "ADD", VK_ADD },
+    { "SEPARATOR", VK_SEPARATOR }, { "SUBTRACT", VK_SUBTRACT }, { "DECIMAL", VK_DECIMAL },
+    { "DIVIDE", VK_DIVIDE },
+    // punctuation of US layout
+    { ";", VK_OEM_1 }, { "=", VK_OEM_PLUS }, { ",", VK_OEM_COMMA }, { "-", VK_OEM_MINUS },
+    { ".", VK_OEM_PERIOD }, { "/", VK_OEM_2 }, { "[", VK_OEM_4 }, { "\\", VK_OEM_5 },
+    { "]", VK_OEM_6 }, { "'", VK_OEM_7 }, { "OEM8", VK_OEM_8 }, { "OEM102", VK_OEM_102 },
+    { "OEMCLEAR", VK_OEM_CLEAR },
+    // browser, media and launch keys
+    { "BROWSERBACK", VK_BROWSER_BACK }, { "BROWSERFORWARD", VK_BROWSER_FORWARD },
+    { "BROWSERREFRESH", VK_BROWSER_REFRESH }, { "BROWSERSTOP", VK_BROWSER_STOP },
+    { "BROWSERSEARCH", VK_BROWSER_SEARCH }, { "BROWSERFAVORITES", VK_BROWSER_FAVORITES },
+    { "BROWSERHOME", VK_BROWSER_HOME }, { "VOLUMEMUTE", VK_VOLUME_MUTE },
+    { "VOLUMEDOWN", VK_VOLUME_DOWN }, { "VOLUMEUP", VK_VOLUME_UP },
+    { "MEDIANEXT", VK_MEDIA_NEXT_TRACK }, { "MEDIAPREV", VK_MEDIA_PREV_TRACK },
+    { "MEDIASTOP", VK_MEDIA_STOP }, { "MEDIAPLAYPAUSE", VK_MEDIA_PLAY_PAUSE },
+    { "LAUNCHMAIL", VK_LAUNCH_MAIL }, { "LAUNCHMEDIA", VK_LAUNCH_MEDIA_SELECT },
+    { "LAUNCHAPP1", VK_LAUNCH_APP1 }, { "LAUNCHAPP2", VK_LAUNCH_APP2 },
+    // input method editor
+    { "KANA", VK_KANA }, { "HANGUL", VK_HANGUL }, { "JUNJA", VK_JUNJA }, { "FINAL", VK_FINAL },
+    { "HANJA", VK_HANJA }, { "KANJI", VK_KANJI }, { "CONVERT", VK_CONVERT },
+    { "NONCONVERT", VK_NONCONVERT }, { "ACCEPT", VK_ACCEPT }, { "MODECHANGE", VK_MODECHANGE },
+    { "PROCESSKEY", VK_PROCESSKEY },
+    // terminal keys
+    { "ATTN", VK_ATTN }, { "CRSEL", VK_CRSEL }, { "EXSEL", VK_EXSEL }, { "EREOF", VK_EREOF },
+    { "PLAY", VK_PLAY }, { "ZOOM", VK_ZOOM }, { "PA1", VK_PA1 },
+};
+
+#define SETTING(section, key, type, member, default_value, min_value, max_value, change) \
+    { section, key, IniType::type, offsetof(Configure::Settings, member), \
+            sizeof(Configure::Settings::member), default_value, min_value, max_value, \
+            Configure::change }
+#define SETTING_AT(section, key, type, member, index, default_value, change) \
+    { section, key, IniType::type, \
+            offsetof(Configure::Settings, member) + sizeof(Configure::Settings::member[0]) * index, \
+            sizeof(Configure::Settings::member[0]), default_value, kIniNoMin, kIniNoMax, \
+            Configure::change }
+
+constexpr IniField kSettingFields[] = {
+    SETTING("General", "bAutoStart", Bool, auto_start, "0", kIniNoMin, kIniNoMax, ChangeAutoStart),
+    SETTING("General", "bRunAsAdmin", Bool, run_as_admin, "0", kIniNoMin, kIniNoMax, ChangeRestart),
+
+    SETTING("Window Filter", "bIgnoreMinimized", Bool, ignore_minimized, "0",
+            kIniNoMin, kIniNoMax, ChangeNone),
+
+    SETTING("UI", "sFontFamily", String, font_family, "Segoe UI",
+            kIniNoMin, kIniNoMax, ChangeViewContent),
+    SETTING("UI", "fFontSize", Float, font_size, "8", kIniNoMin, kIniNoMax, ChangeViewContent),
+    SETTING("UI", "fBackgroundAlpha", Float, background_alpha, "0.8", 0.01, 1, ChangeAlpha),
+    SETTING("UI", "bSingleLayeredWindow", Bool, single_layered_window, "0",
+            kIniNoMin, kIniNoMax, ChangeRestart),
+    SETTING("UI", "bCloakHiddenViews", Bool, cloak_hidden_views, "0",
+            kIniNoMin, kIniNoMax, ChangeCloak),
+    SETTING("UI", "bCompactMode", Bool, compact_mode, "0", kIniNoMin, kIniNoMax, ChangeViewContent),
+    SETTING("UI", "iShowDelay", Int, show_delay, "0", 0, kIniNoMax, ChangeNone),
+    SETTING("UI", "bHighlightJumpTarget", Bool, highlight_jump_target, "1",
+            kIniNoMin, kIniNoMax, ChangeNone),
+
+    SETTING("Hotkeys", "kSwitchGroupkey", Key, switch_group_key, "F1",
+            kIniNoMin, kIniNoMax, ChangeHotkeys),
+    SETTING("Hotkeys", "bEnablePrevGroupHotkey", Bool, enable_prev_group_hotkey, "0",
+            kIniNoMin, kIniNoMax, ChangeHotkeys),
+    SETTING("Hotkeys", "kSwitchWindowkey", Key, switch_window_key, "F2",
+            kIniNoMin, kIniNoMax, ChangeHotkeys),
+    SETTING("Hotkeys", "bEnablePrevWindowHotkey", Bool, enable_prev_window_hotkey, "0",
+            kIniNoMin, kIniNoMax, ChangeHotkeys),
+    SETTING("Hotkeys", "kSwitchMonitorkey", Key, switch_monitor_key, "F3",
+            kIniNoMin, kIniNoMax, ChangeHotkeys),
+    SETTING("Hotkeys", "bEnablePrevMonitorHotkey", Bool, enable_prev_monitor_hotkey, "0",
+            kIniNoMin, kIniNoMax, ChangeHotkeys),
+    SETTING("Hotkeys", "hKeepShowingHotkey", Hotkey, keep_showing_hotkey, "0",
+            kIniNoMin, kIniNoMax, ChangeHotkeys),
+    SETTING("Hotkeys", "bEnableGroupJumpHotkeys", Bool, enable_group_jump_hotkeys, "0",
+            kIniNoMin, kIniNoMax, ChangeHotkeys),
+    SETTING_AT("Hotkeys", "hPinnedWindowHotkey1", Hotkey, pinned_window_hotkeys, 0,
+            "0", ChangeHotkeys),
+    SETTING_AT("Hotkeys", "sPinnedWindow1", String, pinned_windows, 0, "", ChangeHotkeys),
+    SETTING_AT("Hotkeys", "hPinnedWindowHotkey2", Hotkey, pinned_window_hotkeys, 1,
+            "0", ChangeHotkeys),
+    SETTING_AT("Hotkeys", "sPinnedWindow2", String, pinned_windows, 1, "", ChangeHotkeys),
+    SETTING_AT("Hotkeys", "hPinnedWindowHotkey3", Hotkey, pinned_window_hotkeys, 2,
+            "0", ChangeHotkeys),
+    SETTING_AT("Hotkeys", "sPinnedWindow3", String, pinned_windows, 2, "", ChangeHotkeys),
+    SETTING_AT("Hotkeys", "hPinnedWindowHotkey4", Hotkey, pinned_window_hotkeys, 3,
+            "0", ChangeHotkeys),
+    SETTING_AT("Hotkeys", "sPinnedWindow4", String, pinned_windows, 3, "", ChangeHotkeys),
+
+    SETTING("Performance", "fPlaceholderScrollSpeed", Float, placeholder_scroll_speed, "1500",
+            0, kIniNoMax, ChangeNone),
+    SETTING("Performance", "iThumbnailSettleDelay", Int, thumbnail_settle_delay, "150",
+            0, kIniNoMax, ChangeNone),
+    SETTING("Performance", "fThumbnailPrefetchBand", Float, thumbnail_prefetch_band, "0.5",
+            0, kIniNoMax, ChangeNone),
+    SETTING("Performance", "iCompactModeThreshold", Int, compact_mode_threshold, "200",
+            0, kIniNoMax, ChangeViewContent),
+    SETTING("Performance", "iIdleTrimDelay", Int, idle_trim_delay, "60",
+            0, kIniNoMax, ChangeIdleTrim),
+};
+
+#undef SETTING_AT
+#undef SETTING
+
+static_assert(validIniSchema(kSettingFields, sizeof(kSettingFields) / sizeof(kSettingFields[0]),
+        sizeof(Configure::Settings)), "type and size of a setting do not match");
+
+constexpr IniSchema kSettingSchema = {
+    kSettingFields, sizeof(kSettingFields) / sizeof(kSettingFields[0]),
+    kKeyNames, sizeof(kKeyNames) / sizeof(kKeyNames[0]),
+    kModifierNames, sizeof(kModifierNames) / sizeof(kModifierNames[0]),
 };
 
-static void writeIntoMember(const std::string &value_str, bool *mem_ptr)
+Configure *config()
 {
-    if (value_str.length() != 1 || !mem_ptr)
-        return;
-    if (value_str[0] == '0') {
-        *mem_ptr = false;
-    } else {
-        *mem_ptr = true;
-    }
+    return Configure::instance();
 }
 
-static void writeIntoMember(const std::string &value_str, float *mem_ptr)
+Configure *Configure::instance()
 {
-    if (value_str.empty() || !mem_ptr )
-        return;
-    *mem_ptr = std::stof(value_str);
+    static Configure instance;
+    return &instance;
 }
 
-static void writeIntoMember(const std::string &value_str, UINT *mem_ptr)
+std::wstring Configure::filePath()
 {
-    if (value_str.empty() || !mem_ptr )
-        return;
-
-    auto it = kKeyMap.find(value_str);
-    if (it != kKeyMap.end()) {
-        *mem_ptr = it->second;
-    } else if (value_str.length() == 1
-            && (value_str[0] >= 'A' && value_str[0] <= 'Z'
-                || value_str[0] >= '0' && value_str[0] <= '9')) {
-        *mem_ptr = value_str[0];
-    }
+    return programDir() + kConfigFile;
 }
 
-static void writeIntoMember(const std::string &value_str, Configure::HotkeyPair *mem_ptr)
+bool Configure::load()
 {
-    if (value_str.empty() || !mem_ptr || value_str == "0")
-        return;
-
-    std::vector<std::string> tokens;
-    // add a '+' at the end to simplify splitting
-    std::string str = value_str + '+';
-    // slipt str by '+'
-    size_t pos = str.find('+');
-    while (pos != std::string::npos) {
-        tokens.push_back(str.substr(0, pos));
-        str = str.substr(pos + 1, str.length());
-        pos = str.find('+');
-    }
-    if (tokens.size() < 2 || tokens.size() > 4)
-        return;
-
-    Configure::HotkeyPair backup = *mem_ptr;
-    // parse key
-    std::string key = std::move(tokens.back());
-    tokens.pop_back();
-    writeIntoMember(key, &mem_ptr->second);
-
-    // parse modifiers
-    while (!tokens.empty()) {
-        auto it = kModifierMap.find(tokens.back());
-        if (it == kModifierMap.end()) {
-            *mem_ptr = backup;
-            return;
+    Settings settings;
+    std::vector<IniDiagnostic> diagnostics;
+    const bool success = read(&settings, &diagnostics);
+    apply(settings, std::move(diagnostics));
+    return success;
+}
+
+std::wstring Configure::diagnosticsText(const std::vector<IniDiagnostic> &diagnostics)
+{
+    std::wstring text;
+    for (const IniDiagnostic &diagnostic : diagnostics) {
+        // values are UTF-8
+        const int length = MultiByteToWideChar(CP_UTF8, 0, diagnostic.message.data(),
+                static_cast<int>(diagnostic.message.size()), nullptr, 0);
+        std::wstring message(length, L'\0');
+        if (length > 0) {
+            MultiByteToWideChar(CP_UTF8, 0, diagnostic.message.data(),
+                    static_cast<int>(diagnostic.message.size()), &message[0], length);
         }
-        mem_ptr->first |= it->second;
-        tokens.pop_back();
+        text += std::wstring(kConfigFile) + L" line " + std::to_wstring(diagnostic.line)
+                + L": " + message + L"\n";
     }
+    return text;
 }
 
-static void parseString(const SettingPair &setting_pair, void *mem_ptr)
+bool Configure::read(Settings *settings, std::vector<IniDiagnostic> *diagnostics)
 {
-    if (setting_pair.first.empty() || setting_pair.second.empty()
-            || !mem_ptr)
-        return;
+    const bool success = readSettings(settings, diagnostics);
 
-    switch (setting_pair.first[0]) {
-    case 'b':
-        writeIntoMember(setting_pair.second, static_cast<bool *>(mem_ptr));
-        break;
+    // validate values depending on each other
+    if (settings->switch_group_key == 0)
+        settings->enable_prev_group_hotkey = false;
+    if (settings->switch_window_key == 0)
+        settings->enable_prev_window_hotkey = false;
+    if (settings->switch_monitor_key == 0)
+        settings->enable_prev_monitor_hotkey = false;
 
-    case 'f':
-        writeIntoMember(setting_pair.second, static_cast<float *>(mem_ptr));
-        break;
-
-    case 'k':
-        writeIntoMember(setting_pair.second, static_cast<UINT *>(mem_ptr));
-        break;
-
-    case 'h':
-        writeIntoMember(setting_pair.second, static_cast<Configure::HotkeyPair *>(mem_ptr));
-        break;
-
-    case 's':
-        *static_cast<std::string *>(mem_ptr) = setting_pair.second;
-        break;
-
-    default:
-        break;
-    }
+    return success;
 }
 
-Configure *config()
+unsigned int Configure::compare(const Settings &a, const Settings &b)
 {
-    return Configure::instance();
+    return IniParser(kSettingSchema).changedTags(&a, &b);
 }
 
-Configure *Configure::instance()
+void Configure::apply(const Settings &settings, std::vector<IniDiagnostic> diagnostics)
 {
-    static Configure instance;
-    return &instance;
+    m_settings = settings;
+    m_diagnostics = std::move(diagnostics);
 }
 
-bool Configure::load()
+bool Configure::readSettings(Settings *settings, std::vector<IniDiagnostic> *diagnostics)
 {
-    const std::wstring file_dir = programDir();
-    std::string file_path(file_dir.begin(), file_dir.end());
-    file_path += kConfigFile;
-
-    std::ifstream file(file_path, std::ios::in);
-    if (!file.is_open())
+    const IniParser parser(kSettingSchema);
+    parser.applyDefaults(settings);
+
+    const std::wstring file_path = filePath();
+    // an editor may be saving the file
+    HANDLE file_handle = CreateFile(file_path.c_str(), GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
         return false;
+    std::unique_ptr<void, decltype(&CloseHandle)> file(file_handle, CloseHandle);
 
-    enum SettingGroup
-    {
-        None,
-        General,
-        WindowFilter,
-        UI,
-        Hotkeys,
-        GroupNumber
-    } current_setting_group = SettingGroup::None;
-
-    static const std::unordered_map<std::string, SettingGroup> group_tag_map = {
-        { "[General]", SettingGroup::General },
-        { "[Window Filter]", SettingGroup::WindowFilter },
-        { "[UI]", SettingGroup::UI },
-        { "[Hotkeys]", SettingGroup::Hotkeys },
-    };
-
-    using ConfigMap = std::unordered_map<std::string, void *>;
-    const std::array<ConfigMap, SettingGroup::GroupNumber> setting_group_map = {
-        ConfigMap{},  // None
-        ConfigMap{  // General
-            { "bAutoStart", &m_auto_start },
-            { "bRunAsAdmin", &m_run_as_admin },
-        },
-        ConfigMap{  // Window Filter
-            { "bIgnoreMinimized", &m_ignore_minimized },
-        },
-        ConfigMap{  // UI
-            { "sFontFamily", &m_font_family },
-            { "fFontSize", &m_font_size },
-            { "fBackgroundAlpha", &m_background_alpha },
-        },
-        ConfigMap{  // Hotkeys
-            { "kSwitchGroupkey", &m_switch_group_key },
-            { "bEnablePrevGroupHotkey", &m_enable_prev_group_hotkey },
-            { "kSwitchWindowkey", &m_switch_window_key },
-            { "bEnablePrevWindowHotkey", &m_enable_prev_window_hotkey },
-            { "kSwitchMonitorkey", &m_switch_monitor_key },
-            { "bEnablePrevMonitorHotkey", &m_enable_prev_monitor_hotkey },
-            { "hKeepShowingHotkey", &m_keep_showing_hotkey },
-        },
-    };
-
-    SettingPair setting_pair;
-    std::string buffer;
-    while (std::getline(file, buffer)) {
-        // ignore empty lines and comments
-        if (buffer.empty() || buffer[0] == '#')
-            continue;
-
-        // current line is group tag
-        if (buffer[0] == '[')
-            current_setting_group = SettingGroup::None;
-
-        if (current_setting_group == SettingGroup::None) {
-            auto it = group_tag_map.find(buffer);
-            if (it != group_tag_map.end()) {
-                current_setting_group = it->second;
-            } else {
-                continue;
-            }
-        } else {
-            std::smatch match;
-            if (!std::regex_search(buffer, match, std::regex("\s*^(.*)\s*=\s*(.*)\s*$"))
-                    || match.size() < 2) {
-                continue;
-            }
-            setting_pair = { std::move(match[1].str()), std::move(match[2].str()) };
-
-            const ConfigMap &config_map = setting_group_map[current_setting_group];
-            auto it = config_map.find(setting_pair.first);
-            // write into member
-            if (it != config_map.end())
-                parseString(setting_pair, it->second);
-        }
-    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file.get(), &size))
+        return false;
+    // empty file can not be mapped
+    if (size.QuadPart == 0)
+        return true;
 
-    // validate values
-    if (m_background_alpha > 1.0f) {
-        m_background_alpha = 1.0f;
-    } else if (m_background_alpha < 0.01f) {
-        m_background_alpha = 0.01f;
-    }
-    if (m_switch_group_key == 0)
-        m_enable_prev_group_hotkey = false;
-    if (m_switch_window_key == 0)
-        m_enable_prev_window_hotkey = false;
-    if (m_switch_monitor_key == 0)
-        m_enable_prev_monitor_hotkey = false;
+    std::unique_ptr<void, decltype(&CloseHandle)> mapping(
+            CreateFileMapping(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr), CloseHandle);
+    if (!mapping)
+        return false;
+    std::unique_ptr<const void, decltype(&UnmapViewOfFile)> view(
+            MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0), UnmapViewOfFile);
+    if (!view)
+        return false;
 
+    parser.parse(static_cast<const char *>(view.get()), static_cast<size_t>(size.QuadPart),
+            settings, diagnostics);
     return true;
 }
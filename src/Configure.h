@@ -1,60 +1,136 @@
 #pragma once
 
+#include "utils/IniParser.h"
+
 #include <Windows.h>
 
 #include <string>
 #include <utility>
+#include <vector>
 
 class Configure
 {
 public:
     using HotkeyPair = std::pair<UINT, UINT>;
 
+    static constexpr size_t kPinnedWindowCount = 4;
+    static constexpr size_t kPinnedWindowLength = 256;
+
+    // what a reload refreshes when a setting changes, tags of the schema
+    enum SettingChange
+    {
+        ChangeNone = 0,  // read again where it is used
+        ChangeAutoStart = 1 << 0,
+        ChangeRestart = 1 << 1,  // applied at the next start
+        ChangeHotkeys = 1 << 2,  // hotkeys and pinned windows in the hook table
+        ChangeViewContent = 1 << 3,  // font and layout, rendered views are drawn again
+        ChangeAlpha = 1 << 4,
+        ChangeCloak = 1 << 5,
+        ChangeIdleTrim = 1 << 6
+    };
+
+    // plain data described by the schema of the ini file, defaults are in the schema
+    struct Settings
+    {
+        // general settings
+        bool auto_start;
+        bool run_as_admin;
+
+        // window filter settings
+        bool ignore_minimized;
+
+        // ui settings
+        char font_family[LF_FACESIZE];
+        float font_size;
+        float background_alpha;
+        bool single_layered_window;
+        bool cloak_hidden_views;
+        bool compact_mode;
+        int show_delay;  // milliseconds, 0 means show at once
+        bool highlight_jump_target;
+
+        // hotkeys settings
+        UINT switch_group_key;
+        bool enable_prev_group_hotkey;
+        UINT switch_window_key;
+        bool enable_prev_window_hotkey;
+        UINT switch_monitor_key;
+        bool enable_prev_monitor_hotkey;
+        HotkeyPair keep_showing_hotkey;
+        bool enable_group_jump_hotkeys;
+        HotkeyPair pinned_window_hotkeys[kPinnedWindowCount];
+        char pinned_windows[kPinnedWindowCount][kPinnedWindowLength];
+
+        // performance settings
+        float placeholder_scroll_speed;  // pixels per second, 0 means always live
+        int thumbnail_settle_delay;  // milliseconds
+        float thumbnail_prefetch_band;  // times of view height
+        int compact_mode_threshold;  // window count, 0 means never
+        int idle_trim_delay;  // seconds, 0 means never
+    };
+
     static Configure *instance();
 
-    bool autoStart() const { return m_auto_start; }
-    bool runAsAdmin() const { return m_run_as_admin; }
+    bool autoStart() const { return m_settings.auto_start; }
+    bool runAsAdmin() const { return m_settings.run_as_admin; }
+
+    bool ignoreMinimized() const { return m_settings.ignore_minimized; }
 
-    bool ignoreMinimized() const { return m_ignore_minimized; }
+    const char *fontFamily() const { return m_settings.font_family; }
+    float fontSize() const { return m_settings.font_size; }
+    float backgroundAlpha() const { return m_settings.background_alpha; }
+    bool singleLayeredWindow() const { return m_settings.single_layered_window; }
+    bool cloakHiddenViews() const { return m_settings.cloak_hidden_views; }
+    bool compactMode() const { return m_settings.compact_mode; }
+    int showDelay() const { return m_settings.show_delay; }
+    bool highlightJumpTarget() const { return m_settings.highlight_jump_target; }
 
-    const std::string &fontFamily() const { return m_font_family; }
-    float fontSize() const { return m_font_size; }
-    float backgroundAlpha() const { return m_background_alpha; }
+    UINT switchGroupkey() const { return m_settings.switch_group_key; }
+    bool enablePrevGroupHotkey() const { return m_settings.enable_prev_group_hotkey; }
+    UINT switchWindowkey() const { return m_settings.switch_window_key; }
+    bool enablePrevWindowHotkey() const { return m_settings.enable_prev_window_hotkey; }
+    UINT switchMonitorkey() const { return m_settings.switch_monitor_key; }
+    bool enablePrevMonitorHotkey() const { return m_settings.enable_prev_monitor_hotkey; }
+    const HotkeyPair &keepShowingHotkey() const { return m_settings.keep_showing_hotkey; }
+    bool enableGroupJumpHotkeys() const { return m_settings.enable_group_jump_hotkeys; }
+    const HotkeyPair &pinnedWindowHotkey(size_t index) const
+    {
+        return m_settings.pinned_window_hotkeys[index];
+    }
+    // "exe name|part of title"
+    const char *pinnedWindow(size_t index) const { return m_settings.pinned_windows[index]; }
 
-    UINT switchGroupkey() const { return m_switch_group_key; }
-    bool enablePrevGroupHotkey() const { return m_enable_prev_group_hotkey; }
-    UINT switchWindowkey() const { return m_switch_window_key; }
-    bool enablePrevWindowHotkey() const { return m_enable_prev_window_hotkey; }
-    UINT switchMonitorkey() const { return m_switch_monitor_key; }
-    bool enablePrevMonitorHotkey() const { return m_enable_prev_monitor_hotkey; }
-    const HotkeyPair &keepShowingHotkey() const { return m_keep_showing_hotkey; }
+    float placeholderScrollSpeed() const { return m_settings.placeholder_scroll_speed; }
+    int thumbnailSettleDelay() const { return m_settings.thumbnail_settle_delay; }
+    float thumbnailPrefetchBand() const { return m_settings.thumbnail_prefetch_band; }
+    int compactModeThreshold() const { return m_settings.compact_mode_threshold; }
+    int idleTrimDelay() const { return m_settings.idle_trim_delay; }
+
+    static std::wstring filePath();
+    const Settings &settings() const { return m_settings; }
 
     bool load();
+    // unknown keys and bad values of the last load, with line numbers
+    const std::vector<IniDiagnostic> &diagnostics() const { return m_diagnostics; }
+    std::wstring diagnosticsText() const { return diagnosticsText(m_diagnostics); }
+    static std::wstring diagnosticsText(const std::vector<IniDiagnostic> &diagnostics);
+
+    // settings of the file without replacing the current ones, false if it can not be read
+    static bool read(Settings *settings, std::vector<IniDiagnostic> *diagnostics);
+    // SettingChange bits of the settings differing
+    static unsigned int compare(const Settings &a, const Settings &b);
+    // replace settings of a reload on the thread reading them
+    void apply(const Settings &settings, std::vector<IniDiagnostic> diagnostics);
 
 private:
     Configure() = default;
     ~Configure() = default;
 
-    // general settings
-    bool m_auto_start = false;
-    bool m_run_as_admin = false;
-
-    // window filter settings
-    bool m_ignore_minimized = false;
-
-    // ui settings
-    std::string m_font_family = "Segoe UI";
-    float m_font_size = 8;
-    float m_background_alpha = 0.8f;
-
-    // hotkeys settings
-    UINT m_switch_group_key = VK_F1;
-    bool m_enable_prev_group_hotkey = false;
-    UINT m_switch_window_key = VK_F2;
-    bool m_enable_prev_window_hotkey = false;
-    UINT m_switch_monitor_key = VK_F3;
-    bool m_enable_prev_monitor_hotkey = false;
-    HotkeyPair m_keep_showing_hotkey = { 0, 0 };
+    // defaults overwritten by the file, false if it can not be read
+    static bool readSettings(Settings *settings, std::vector<IniDiagnostic> *diagnostics);
+
+    Settings m_settings = {};
+    std::vector<IniDiagnostic> m_diagnostics;
 };
 
 Configure *config();
@@ -0,0 +1,173 @@
+#include "FrameScheduler.h"
+#include "Metrics.h"
+#include "resource.h"
+
+#include <algorithm>
+
+static bool inputPending()
+{
+    // hotkey commands from the message thread and pending frames arrive as posted messages
+    return HIWORD(GetQueueStatus(QS_INPUT | QS_SENDMESSAGE | QS_POSTMESSAGE)) != 0;
+}
+
+bool FrameScheduler::create(HINSTANCE instance)
+{
+    if (m_hwnd)
+        return true;
+
+    m_hwnd = {
+        CreateWindow(
+            L"GroupTabBox", L"FrameScheduler",
+            0, 0, 0, 0, 0,
+            HWND_MESSAGE, nullptr, instance, nullptr
+        ),
+        DestroyWindow
+    };
+    return m_hwnd.get();
+}
+
+LRESULT FrameScheduler::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+    if (hwnd != m_hwnd.get())
+        return -1;
+
+    switch (uMsg) {
+    case WM_DESTROY:
+        m_hwnd.release();
+        return 0;
+
+    case WM_TIMER:
+        if (wParam == TimerIDWork) {
+            tick();
+        } else if (wParam == TimerIDFrame) {
+            KillTimer(m_hwnd.get(), TimerIDFrame);
+            runFrames();
+        }
+        return 0;
+
+    case WMAPP_FRAME:
+        runFrames();
+        return 0;
+
+    default:
+        break;
+    }
+    return -1;
+}
+
+void FrameScheduler::setRefreshRate(UINT hz)
+{
+    if (hz > 1)
+        m_refresh_interval = 1000000 / hz;
+}
+
+void FrameScheduler::post(const void *owner, Task task, bool urgent)
+{
+    if (urgent) {
+        m_tasks.emplace_front(owner, std::move(task));
+    } else {
+        m_tasks.emplace_back(owner, std::move(task));
+    }
+    updateWorkTimer();
+}
+
+void FrameScheduler::requestFrame(const void *owner, Task callback)
+{
+    auto it = std::find_if(m_frames.begin(), m_frames.end(),
+            [owner](const std::pair<const void *, Task> &frame) { return frame.first == owner; });
+    if (it != m_frames.end()) {
+        it->second = std::move(callback);
+    } else {
+        m_frames.emplace_back(owner, std::move(callback));
+    }
+    scheduleFrame();
+}
+
+void FrameScheduler::cancel(const void *owner)
+{
+    auto is_owner = [owner](const std::pair<const void *, Task> &work) { return work.first == owner; };
+    m_tasks.erase(std::remove_if(m_tasks.begin(), m_tasks.end(), is_owner), m_tasks.end());
+    m_frames.erase(std::remove_if(m_frames.begin(), m_frames.end(), is_owner), m_frames.end());
+    updateWorkTimer();
+}
+
+void FrameScheduler::flush(const void *owner)
+{
+    auto is_owner = [owner](const std::pair<const void *, Task> &work) { return work.first == owner; };
+
+    // tasks may queue more work of the same owner
+    while (true) {
+        auto it = std::find_if(m_tasks.begin(), m_tasks.end(), is_owner);
+        if (it != m_tasks.end()) {
+            Task task = std::move(it->second);
+            m_tasks.erase(it);
+            task();
+            continue;
+        }
+
+        auto frame_it = std::find_if(m_frames.begin(), m_frames.end(), is_owner);
+        if (frame_it == m_frames.end())
+            break;
+        Task callback = std::move(frame_it->second);
+        m_frames.erase(frame_it);
+        callback();
+    }
+    updateWorkTimer();
+}
+
+void FrameScheduler::tick()
+{
+    const uint64_t start = currentMicroseconds();
+    while (!m_tasks.empty()) {
+        Task task = std::move(m_tasks.front().second);
+        m_tasks.pop_front();
+        task();
+
+        if (currentMicroseconds() - start >= kFrameBudget || inputPending())
+            break;
+    }
+    updateWorkTimer();
+}
+
+void FrameScheduler::runFrames()
+{
+    m_frame_scheduled = false;
+    m_last_frame_time = currentMicroseconds();
+
+    // callbacks may request new frames, they run in the next frame
+    std::vector<std::pair<const void *, Task>> frames;
+    frames.swap(m_frames);
+    for (auto &frame : frames)
+        frame.second();
+
+    if (!frames.empty())
+        metrics()->frameTime().record(currentMicroseconds() - m_last_frame_time);
+}
+
+void FrameScheduler::scheduleFrame()
+{
+    if (m_frame_scheduled || !m_hwnd)
+        return;
+    m_frame_scheduled = true;
+
+    const uint64_t elapsed = currentMicroseconds() - m_last_frame_time;
+    if (elapsed >= m_refresh_interval) {
+        // posted message runs after hotkeys already sent to this thread, so they are merged
+        PostMessage(m_hwnd.get(), WMAPP_FRAME, 0, 0);
+    } else {
+        const UINT delay = static_cast<UINT>((m_refresh_interval - elapsed + 999) / 1000);
+        SetTimer(m_hwnd.get(), TimerIDFrame, max(delay, static_cast<UINT>(USER_TIMER_MINIMUM)), nullptr);
+    }
+}
+
+void FrameScheduler::updateWorkTimer()
+{
+    if (m_tasks.empty()) {
+        if (m_work_timer) {
+            KillTimer(m_hwnd.get(), TimerIDWork);
+            m_work_timer = false;
+        }
+    } else if (!m_work_timer && m_hwnd) {
+        m_work_timer = SetTimer(m_hwnd.get(), TimerIDWork, kTickInterval, nullptr) != 0;
+    }
+}
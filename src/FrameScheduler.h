@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// runs deferred work in time-budgeted slices on timer ticks, yields to pending input
+// so hotkeys are never delayed by background work. frames requested by views are
+// merged and rendered at most once per display refresh
+class FrameScheduler
+{
+public:
+    using Task = std::function<void()>;
+
+    static constexpr UINT kTickInterval = USER_TIMER_MINIMUM;
+    static constexpr uint64_t kFrameBudget = 8000;  // microseconds
+
+    bool create(HINSTANCE instance);
+    LRESULT handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+    bool idle() const { return m_tasks.empty() && m_frames.empty(); }
+    void setRefreshRate(UINT hz);
+
+    // queue work of owner, urgent work runs before other queued work
+    void post(const void *owner, Task task, bool urgent = false);
+    // run callback in the next frame, repeated requests of an owner are merged
+    void requestFrame(const void *owner, Task callback);
+    // drop all work of owner
+    void cancel(const void *owner);
+    // run all work of owner now
+    void flush(const void *owner);
+
+private:
+    enum TimerID
+    {
+        TimerIDWork = 1,
+        TimerIDFrame
+    };
+
+    void tick();
+    void runFrames();
+    void scheduleFrame();
+    void updateWorkTimer();
+
+    std::unique_ptr<HWND__, decltype(&DestroyWindow)> m_hwnd = { nullptr, DestroyWindow };
+
+    std::deque<std::pair<const void *, Task>> m_tasks;
+    bool m_work_timer = false;
+
+    std::vector<std::pair<const void *, Task>> m_frames;
+    bool m_frame_scheduled = false;
+    uint64_t m_last_frame_time = 0;
+    uint64_t m_refresh_interval = 1000000 / 60;  // microseconds
+};
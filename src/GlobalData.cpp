@@ -1,12 +1,22 @@
 #include "GlobalData.h"
+#include "ConfigWatcher.h"
 #include "Configure.h"
+#include "FrameScheduler.h"
+#include "HighlightWindow.h"
+#include "HookWatchdog.h"
 #include "KeyboardHook.h"
 #include "MainWindow.h"
+#include "Metrics.h"
+#include "RenderThread.h"
+#include "SnapshotCache.h"
+#include "ThumbnailPool.h"
 #include "ThumbnailWindow.h"
 #include "UIParam.h"
 
 #include <ShellScalingApi.h>
 
+#include <algorithm>
+
 #pragma comment(lib, "shcore.lib")
 
 BOOL CALLBACK enumWindowsProc(HWND hwnd, LPARAM lParam)
@@ -22,6 +32,25 @@ BOOL CALLBACK enumMonitorsProc(HMONITOR monitor, HDC hdc, LPRECT lprc, LPARAM lP
     return TRUE;
 }
 
+void CALLBACK foregroundEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+        LONG id_object, LONG id_child, DWORD event_thread, DWORD event_time)
+{
+    if (hwnd && id_object == OBJID_WINDOW && id_child == CHILDID_SELF)
+        globalData()->m_window_mru.touch(hwnd);
+}
+
+static void CALLBACK prerenderTimerProc(HWND hwnd, UINT uMsg, UINT_PTR id, DWORD time)
+{
+    KillTimer(nullptr, id);
+    globalData()->prerenderViews();
+}
+
+static void CALLBACK idleTimerProc(HWND hwnd, UINT uMsg, UINT_PTR id, DWORD time)
+{
+    KillTimer(nullptr, id);
+    globalData()->trimIdleResources();
+}
+
 GlobalData *globalData()
 {
     return GlobalData::instance();
@@ -41,6 +70,46 @@ const std::vector<WindowHandle *> &GlobalData::windowsFromGroup(const WindowGrou
     return m_window_groups[it->second];
 }
 
+const WindowHandle *GlobalData::recentWindowOfOtherGroup(HMONITOR monitor) const
+{
+    // recent use is tracked after the snapshot too, only its windows are switched to
+    const HWND foreground = GetForegroundWindow();
+    auto foreground_it = m_window_index.find(foreground);
+    const WindowHandle *foreground_window =
+            foreground_it != m_window_index.end() ? &m_windows[foreground_it->second] : nullptr;
+
+    for (HWND hwnd : m_window_mru) {
+        auto it = m_window_index.find(hwnd);
+        if (hwnd == foreground || it == m_window_index.end())
+            continue;
+        const WindowHandle &window = m_windows[it->second];
+        if (window.monitor() != monitor)
+            continue;
+        if (foreground_window && window.group() == foreground_window->group())
+            continue;
+        // closed since the snapshot
+        if (!IsWindow(hwnd))
+            continue;
+        return &window;
+    }
+    return nullptr;
+}
+
+const WindowHandle *GlobalData::windowOfGroupAt(HMONITOR monitor, size_t index) const
+{
+    for (const auto &group : m_window_groups) {
+        for (WindowHandle *window : group) {
+            if (window->monitor() != monitor)
+                continue;
+            if (index == 0)
+                return window;
+            --index;
+            break;
+        }
+    }
+    return nullptr;
+}
+
 RectF GlobalData::groupWindowLimitRect() const
 {
     RectF rect;
@@ -83,6 +152,12 @@ void GlobalData::setCurrentMonitor(HMONITOR monitor)
     GetDpiForMonitor(m_current_monitor, MDT_EFFECTIVE_DPI, &dpi, &dpi);
     m_monitor_scale = dpi / 96.0f;
     m_ui->update(m_monitor_scale);
+
+    // render at most once per refresh of current monitor
+    DEVMODE mode = {};
+    mode.dmSize = sizeof(mode);
+    if (m_frame_scheduler && EnumDisplaySettings(m_monitor_info.szDevice, ENUM_CURRENT_SETTINGS, &mode))
+        m_frame_scheduler->setRefreshRate(mode.dmDisplayFrequency);
 }
 
 bool GlobalData::initialize(HINSTANCE instance)
@@ -93,6 +168,7 @@ bool GlobalData::initialize(HINSTANCE instance)
         m_keyboard_hook = std::make_unique<KeyboardHook>();
         if (!m_keyboard_hook || !m_keyboard_hook->initialize(instance))
             return false;
+        metrics()->setHookTime(m_keyboard_hook->hookTime());
     }
 
     if (!m_ui) {
@@ -106,6 +182,69 @@ bool GlobalData::initialize(HINSTANCE instance)
         if (!m_main_window || !m_main_window->create(instance))
             return false;
     }
+
+    if (!m_hook_watchdog) {
+        m_hook_watchdog = std::make_unique<HookWatchdog>();
+        // hotkeys work without the watchdog until the hook is removed
+        if (m_hook_watchdog && !m_hook_watchdog->initialize(m_main_window->hwnd()))
+            m_hook_watchdog.reset();
+    }
+
+    if (!m_config_watcher) {
+        m_config_watcher = std::make_unique<ConfigWatcher>();
+        // settings are read once without the watcher
+        if (m_config_watcher && !m_config_watcher->start(m_main_window->hwnd()))
+            m_config_watcher.reset();
+    }
+
+    if (!m_render_thread) {
+        m_render_thread = std::make_unique<RenderThread>();
+        if (!m_render_thread || !m_render_thread->start(instance))
+            return false;
+    }
+
+    return true;
+}
+
+void GlobalData::destroy()
+{
+    // reloads post commands to render thread
+    m_config_watcher.reset();
+    // commands of render thread refer to main window
+    m_render_thread.reset();
+    m_main_window.reset();
+}
+
+bool GlobalData::initializeViews(HINSTANCE instance)
+{
+    if (!m_thumbnail_pool) {
+        m_thumbnail_pool = std::make_unique<ThumbnailPool>();
+        if (!m_thumbnail_pool)
+            return false;
+    }
+
+    if (!m_frame_scheduler) {
+        m_frame_scheduler = std::make_unique<FrameScheduler>();
+        if (!m_frame_scheduler || !m_frame_scheduler->create(instance))
+            return false;
+    }
+
+    // without foreground events windows keep z-order from the last enumeration
+    if (!m_foreground_hook) {
+        m_foreground_hook = {
+            SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                    foregroundEventProc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS),
+            UnhookWinEvent
+        };
+    }
+
+    // previews of minimized windows are optional
+    if (!m_snapshot_cache) {
+        m_snapshot_cache = std::make_unique<SnapshotCache>();
+        if (m_snapshot_cache && !m_snapshot_cache->initialize())
+            m_snapshot_cache.reset();
+    }
+
     if (!m_group_window) {
         m_group_window = std::make_unique<GroupThumbnailWindow>();
         if (!m_group_window || !m_group_window->create(instance))
@@ -117,14 +256,117 @@ bool GlobalData::initialize(HINSTANCE instance)
             return false;
     }
 
+    // direct jumps work without the highlight
+    if (!m_highlight_window) {
+        m_highlight_window = std::make_unique<HighlightWindow>();
+        if (m_highlight_window && !m_highlight_window->create(instance))
+            m_highlight_window.reset();
+    }
+
+    // first show is an uncloak too
+    if (config()->cloakHiddenViews())
+        schedulePrerender();
+
     return true;
 }
 
-void GlobalData::destroy()
+void GlobalData::schedulePrerender()
 {
-    m_main_window.reset();
+    if (m_prerender_timer)
+        KillTimer(nullptr, m_prerender_timer);
+    m_prerender_timer = SetTimer(nullptr, 0, kPrerenderDelay, prerenderTimerProc);
+}
+
+void GlobalData::prerenderViews()
+{
+    m_prerender_timer = 0;
+    if (!m_group_window || m_group_window->visible() || m_list_window->visible())
+        return;
+
+    HWND foreground = GetForegroundWindow();
+    if (!foreground || !update(MonitorFromWindow(foreground, MONITOR_DEFAULTTONEAREST)))
+        return;
+    // group window renders the list window of its selected group
+    m_group_window->prerender();
+}
+
+void GlobalData::scheduleIdleTrim()
+{
+    if (m_idle_timer) {
+        KillTimer(nullptr, m_idle_timer);
+        m_idle_timer = 0;
+    }
+    m_next_trim_tier = TrimTierSurfaces;
+
+    const int delay = config()->idleTrimDelay();
+    if (delay > 0)
+        m_idle_timer = SetTimer(nullptr, 0, delay * 1000, idleTimerProc);
+}
+
+void GlobalData::trimIdleResources()
+{
+    m_idle_timer = 0;
+    if (!m_group_window || m_group_window->visible() || m_list_window->visible())
+        return;
+
+    const size_t before = currentWorkingSet();
+    const int tier = m_next_trim_tier;
+    if (tier == TrimTierSurfaces) {
+        m_group_window->trim();
+        m_list_window->trim();
+        m_thumbnail_pool->releaseAll();
+    } else {
+        // window snapshot, layouts and titles are kept, icons are loaded again after show
+        for (auto &window : m_windows)
+            window.releaseIcon();
+        WindowHandle::clearUWPIconCache();
+    }
+    // return freed pages, they are faulted in again on the next show
+    SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1));
+    metrics()->recordTrim(tier, before, currentWorkingSet());
+
+    m_next_trim_tier = tier + 1;
+    if (m_next_trim_tier < TrimTierNumber)
+        m_idle_timer = SetTimer(nullptr, 0, config()->idleTrimDelay() * 1000, idleTimerProc);
+}
+
+void GlobalData::refreshSettings(unsigned int changes)
+{
+    // font is created from UI parameters when items are drawn
+    if (changes & Configure::ChangeViewContent)
+        m_ui->update(m_monitor_scale);
+
+    if (m_group_window)
+        m_group_window->refreshSettings(changes);
+    if (m_list_window)
+        m_list_window->refreshSettings(changes);
+
+    const unsigned int view_changes =
+            Configure::ChangeViewContent | Configure::ChangeAlpha | Configure::ChangeCloak;
+    if ((changes & view_changes) && config()->cloakHiddenViews())
+        schedulePrerender();
+    if (changes & Configure::ChangeIdleTrim)
+        scheduleIdleTrim();
+}
+
+void GlobalData::destroyViews()
+{
+    if (m_prerender_timer) {
+        KillTimer(nullptr, m_prerender_timer);
+        m_prerender_timer = 0;
+    }
+    if (m_idle_timer) {
+        KillTimer(nullptr, m_idle_timer);
+        m_idle_timer = 0;
+    }
+
+    m_foreground_hook.reset();
+    m_highlight_window.reset();
     m_group_window.reset();
     m_list_window.reset();
+    m_frame_scheduler.reset();
+    m_snapshot_cache.reset();
+    m_thumbnail_pool.reset();
 }
 
 bool GlobalData::update(HMONITOR monitor)
@@ -142,16 +384,41 @@ bool GlobalData::update(HMONITOR monitor)
         return false;
 
     m_active_window = GetForegroundWindow();
+    if (m_active_window)
+        m_window_mru.touch(m_active_window);
 
-    m_windows.clear();
+    std::vector<WindowHandle> previous_windows;
+    previous_windows.swap(m_windows);
     EnumWindows(enumWindowsProc, 0);
+    orderByRecentUse();
+    metrics()->markStage(Metrics::StageSnapshot);
+    if (std::equal(m_windows.begin(), m_windows.end(),
+            previous_windows.begin(), previous_windows.end(),
+            [](const WindowHandle &a, const WindowHandle &b) { return a.sameAttributes(b); })) {
+        // keep the previous snapshot, views built from it stay current
+        m_windows.swap(previous_windows);
+        return !m_windows.empty();
+    }
+    ++m_snapshot_version;
+
+    // layouts, cached lists and scheduled work of the hidden views refer to old windows,
+    // which are released with previous_windows
+    m_group_window->releaseLayout();
+    m_list_window->releaseLayout();
     if (m_windows.empty())
         return false;
     WindowHandle::updateUWPIconCache();
+    // registrations of closed windows are no longer needed
+    m_thumbnail_pool->prune();
+    if (m_snapshot_cache)
+        m_snapshot_cache->prune();
 
+    m_window_index.clear();
     m_group_index.clear();
     m_window_groups.clear();
+    // groups are ordered by their most recent window
     for (auto &window : m_windows) {
+        m_window_index.insert({ window.hwnd(), m_window_index.size() });
         const WindowGroup &group = window.group();
         auto it = m_group_index.find(group);
         if (it != m_group_index.end()) {
@@ -167,6 +434,13 @@ bool GlobalData::update(HMONITOR monitor)
     return true;
 }
 
+void GlobalData::orderByRecentUse()
+{
+    // windows not enumerated may be cloaked or on another desktop, only closed ones are dropped
+    m_window_mru.order(&m_windows, [](const WindowHandle &window) { return window.hwnd(); },
+            [](HWND hwnd) { return !IsWindow(hwnd); });
+}
+
 LRESULT GlobalData::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
     LRESULT res = -1;
@@ -178,6 +452,8 @@ LRESULT GlobalData::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lP
     HANDLE_MSG(m_main_window);
     HANDLE_MSG(m_group_window);
     HANDLE_MSG(m_list_window);
+    HANDLE_MSG(m_highlight_window);
+    HANDLE_MSG(m_frame_scheduler);
 #undef HANDLE_MSG
 
     return DefWindowProc(hwnd, uMsg, wParam, lParam);
@@ -189,7 +465,17 @@ void GlobalData::activateWindow(const WindowHandle *window)
         m_group_window->hide();
     if (m_list_window)
         m_list_window->hide();
+    // prerender after the switch is not part of the key to present latency
+    metrics()->endKeyEvent();
 
-    if (window)
+    if (window) {
         window->activate();
+        // ordered at once, the foreground event follows later
+        m_window_mru.touch(window->hwnd());
+    }
+
+    // z-order changes after activation, render hidden views again when it settles
+    if (config()->cloakHiddenViews())
+        schedulePrerender();
+    scheduleIdleTrim();
 }
@@ -1,20 +1,32 @@
 #pragma once
 
+#include "utils/MruList.h"
 #include "utils/PairHash.h"
 #include "WindowHandle.h"
 
+#include <cstdint>
+
 using Gdiplus::REAL;
 
+class ConfigWatcher;
+class FrameScheduler;
 class GroupThumbnailWindow;
+class HighlightWindow;
+class HookWatchdog;
 class KeyboardHook;
 class ListThumbnailWindow;
 class MainWindow;
+class RenderThread;
+class SnapshotCache;
+class ThumbnailPool;
 class UIParam;
 
 class GlobalData
 {
     friend BOOL enumWindowsProc(HWND hwnd, LPARAM lParam);
     friend BOOL enumMonitorsProc(HMONITOR monitor, HDC hdc, LPRECT lprc, LPARAM lParam);
+    friend void CALLBACK foregroundEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+            LONG id_object, LONG id_child, DWORD event_thread, DWORD event_time);
 
 public:
     static GlobalData *instance();
@@ -27,19 +39,44 @@ public:
     REAL monitorScale() const { return m_monitor_scale; }
     const UIParam *UI() const { return m_ui.get(); }
     const std::vector<WindowHandle> &windows() const { return m_windows; }
+    // changes when update() finds different windows
+    uint64_t snapshotVersion() const { return m_snapshot_version; }
     const std::vector<std::vector<WindowHandle *>> &windowGroups() const { return m_window_groups; }
     const std::vector<WindowHandle *> &windowsFromGroup(const WindowGroup &group) const;
+    // first window of the most recent group besides the foreground one in the last snapshot
+    const WindowHandle *recentWindowOfOtherGroup(HMONITOR monitor) const;
+    // first window of the group at index on monitor in the last snapshot, as the group view
+    const WindowHandle *windowOfGroupAt(HMONITOR monitor, size_t index) const;
     RectF groupWindowLimitRect() const;
     RectF listWindowLimitRect() const;
     MainWindow *mainWindow() const { return m_main_window.get(); }
     GroupThumbnailWindow *groupWindow() const { return m_group_window.get(); }
     ListThumbnailWindow *listWindow() const { return m_list_window.get(); }
+    HighlightWindow *highlightWindow() const { return m_highlight_window.get(); }
     KeyboardHook *keyboardHook() const { return m_keyboard_hook.get(); }
+    HookWatchdog *hookWatchdog() const { return m_hook_watchdog.get(); }
+    ConfigWatcher *configWatcher() const { return m_config_watcher.get(); }
+    ThumbnailPool *thumbnailPool() const { return m_thumbnail_pool.get(); }
+    FrameScheduler *frameScheduler() const { return m_frame_scheduler.get(); }
+    RenderThread *renderThread() const { return m_render_thread.get(); }
+    SnapshotCache *snapshotCache() const { return m_snapshot_cache.get(); }
 
     void setCurrentMonitor(HMONITOR monitor);
 
     bool initialize(HINSTANCE instance);
     void destroy();
+    // views and their resources live on the render thread
+    bool initializeViews(HINSTANCE instance);
+    void destroyViews();
+    // render hidden views while cloaked, so the next show is only an uncloak
+    void schedulePrerender();
+    void prerenderViews();
+    // release resources in tiers while the views stay hidden
+    void scheduleIdleTrim();
+    void trimIdleResources();
+    // Configure::SettingChange bits replaced by a reload, on render thread. snapshot, icons,
+    // thumbnails and cached previews are kept
+    void refreshSettings(unsigned int changes);
     bool update(HMONITOR monitor);
     LRESULT handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
     void activateWindow(const WindowHandle *window);
@@ -48,6 +85,9 @@ private:
     GlobalData() = default;
     ~GlobalData() = default;
 
+    // windows used recently come first, the others keep enumeration order
+    void orderByRecentUse();
+
     HINSTANCE m_hinstance = nullptr;
 
     HWND m_active_window = nullptr;
@@ -58,15 +98,42 @@ private:
 
     std::unique_ptr<UIParam> m_ui = nullptr;
 
+    static constexpr UINT kPrerenderDelay = 300;  // milliseconds
+
+    enum TrimTier
+    {
+        TrimTierSurfaces,  // view surfaces, item details and DWM thumbnails
+        TrimTierIcons,  // icons of windows and UWP icon cache
+        TrimTierNumber
+    };
+
     std::vector<WindowHandle> m_windows;
+    uint64_t m_snapshot_version = 0;
+    std::unordered_map<HWND, size_t> m_window_index;  // index in m_windows
+    // foreground changes tracked on the render thread, orders windows and so their groups
+    MruList<HWND> m_window_mru;
+    std::unique_ptr<HWINEVENTHOOK__, decltype(&UnhookWinEvent)> m_foreground_hook = {
+        nullptr, UnhookWinEvent
+    };
     std::unordered_map<WindowGroup, size_t> m_group_index;
     std::vector<std::vector<WindowHandle *>> m_window_groups;
 
     std::unique_ptr<MainWindow> m_main_window = nullptr;
     std::unique_ptr<GroupThumbnailWindow> m_group_window = nullptr;
     std::unique_ptr<ListThumbnailWindow> m_list_window = nullptr;
+    std::unique_ptr<HighlightWindow> m_highlight_window = nullptr;
 
     std::unique_ptr<KeyboardHook> m_keyboard_hook = nullptr;
+    std::unique_ptr<HookWatchdog> m_hook_watchdog = nullptr;
+    std::unique_ptr<ConfigWatcher> m_config_watcher = nullptr;
+
+    std::unique_ptr<ThumbnailPool> m_thumbnail_pool = nullptr;
+    std::unique_ptr<FrameScheduler> m_frame_scheduler = nullptr;
+    std::unique_ptr<SnapshotCache> m_snapshot_cache = nullptr;
+    std::unique_ptr<RenderThread> m_render_thread = nullptr;
+    UINT_PTR m_prerender_timer = 0;
+    UINT_PTR m_idle_timer = 0;
+    int m_next_trim_tier = TrimTierSurfaces;
 };
 
 GlobalData *globalData();
@@ -0,0 +1,107 @@
+#include "HighlightWindow.h"
+#include "GlobalData.h"
+#include "UIParam.h"
+
+bool HighlightWindow::create(HINSTANCE instance)
+{
+    if (m_hwnd)
+        return true;
+
+    // never takes focus or mouse input from the activated window
+    m_hwnd = {
+        CreateWindowEx(
+            WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_NOACTIVATE,
+            L"GroupTabBox", L"HighlightWindow",
+            WS_POPUP,
+            0, 0, 1, 1,
+            nullptr, nullptr, instance, nullptr
+        ),
+        DestroyWindow
+    };
+    if (!m_hwnd)
+        return false;
+
+    const ARGB color = globalData()->UI()->selectFrameColor();
+    m_brush = {
+        CreateSolidBrush(RGB((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF)),
+        DeleteObject
+    };
+    if (!m_brush)
+        return false;
+    SetLayeredWindowAttributes(m_hwnd.get(), 0, (color >> 24) & 0xFF, LWA_ALPHA);
+
+    return true;
+}
+
+LRESULT HighlightWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+    if (hwnd != m_hwnd.get())
+        return -1;
+
+    switch (uMsg) {
+    case WM_DESTROY:
+        m_hwnd.release();
+        return 0;
+
+    case WM_ERASEBKGND:
+        return 1;
+
+    case WM_PAINT:
+        {
+            // window region leaves only the frame
+            PAINTSTRUCT ps;
+            HDC hdc = BeginPaint(hwnd, &ps);
+            FillRect(hdc, &ps.rcPaint, m_brush.get());
+            EndPaint(hwnd, &ps);
+        }
+        return 0;
+
+    case WM_TIMER:
+        if (wParam == TimerIDHide) {
+            hide();
+            return 0;
+        }
+        break;
+
+    default:
+        break;
+    }
+    return -1;
+}
+
+void HighlightWindow::flash(HWND target)
+{
+    if (!m_hwnd || !target)
+        return;
+
+    RECT rect;
+    if (FAILED(DwmGetWindowAttribute(target, DWMWA_EXTENDED_FRAME_BOUNDS, &rect, sizeof(rect)))
+            && !GetWindowRect(target, &rect))
+        return;
+    const int width = rect.right - rect.left;
+    const int height = rect.bottom - rect.top;
+    const int frame_width = max(1, static_cast<int>(globalData()->UI()->selectFrameWidth()));
+    if (width <= frame_width * 2 || height <= frame_width * 2)
+        return;
+
+    // region is owned by the window after SetWindowRgn
+    HRGN frame = CreateRectRgn(0, 0, width, height);
+    HRGN inner = CreateRectRgn(frame_width, frame_width, width - frame_width, height - frame_width);
+    CombineRgn(frame, frame, inner, RGN_DIFF);
+    DeleteObject(inner);
+    SetWindowRgn(m_hwnd.get(), frame, FALSE);
+
+    SetWindowPos(m_hwnd.get(), HWND_TOPMOST, rect.left, rect.top, width, height,
+            SWP_NOACTIVATE | SWP_SHOWWINDOW);
+    InvalidateRect(m_hwnd.get(), nullptr, FALSE);
+    SetTimer(m_hwnd.get(), TimerIDHide, kFlashTime, nullptr);
+}
+
+void HighlightWindow::hide()
+{
+    if (!m_hwnd)
+        return;
+
+    KillTimer(m_hwnd.get(), TimerIDHide);
+    ShowWindow(m_hwnd.get(), SW_HIDE);
+}
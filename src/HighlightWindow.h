@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <memory>
+
+// frame around a window for a moment, shows where a direct jump went without rendering a view
+class HighlightWindow
+{
+public:
+    static constexpr UINT kFlashTime = 200;  // milliseconds
+
+    bool create(HINSTANCE instance);
+    LRESULT handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+    void flash(HWND target);
+    void hide();
+
+private:
+    enum TimerID
+    {
+        TimerIDHide = 1
+    };
+
+    std::unique_ptr<HWND__, decltype(&DestroyWindow)> m_hwnd = { nullptr, DestroyWindow };
+    std::unique_ptr<HBRUSH__, decltype(&DeleteObject)> m_brush = { nullptr, DeleteObject };
+};
@@ -0,0 +1,84 @@
+#include "HookWatchdog.h"
+#include "GlobalData.h"
+#include "KeyboardHook.h"
+#include "Metrics.h"
+#include "utils/ProgramUtils.h"
+
+#include <fstream>
+
+const wchar_t *kHookIncidentFile = L"hook_incidents.log";
+
+bool HookWatchdog::initialize(HWND hwnd)
+{
+    RAWINPUTDEVICE device = {};
+    device.usUsagePage = 0x01;  // generic desktop
+    device.usUsage = 0x06;  // keyboard
+    device.dwFlags = RIDEV_INPUTSINK;
+    device.hwndTarget = hwnd;
+    if (!RegisterRawInputDevices(&device, 1, sizeof(device)))
+        return false;
+
+    m_last_hook_calls = globalData()->keyboardHook()->health().calls;
+    return true;
+}
+
+void HookWatchdog::handleInput(HRAWINPUT input)
+{
+    RAWINPUTHEADER header;
+    UINT size = sizeof(header);
+    if (GetRawInputData(input, RID_HEADER, &header, &size, sizeof(RAWINPUTHEADER)) == (UINT)-1
+            || header.dwType != RIM_TYPEKEYBOARD)
+        return;
+
+    // the hook sees a key before its raw input is sent, keys swallowed by the hook
+    // send no raw input. a silent hook over a few keys has been removed
+    const HookHealth health = globalData()->keyboardHook()->health();
+    if (health.calls != m_last_hook_calls) {
+        m_last_hook_calls = health.calls;
+        m_missed_keys = 0;
+        return;
+    }
+    if (++m_missed_keys < kMissedKeyLimit)
+        return;
+
+    m_missed_keys = 0;
+    reinstallHook(health);
+}
+
+void HookWatchdog::reinstallHook(const HookHealth &health)
+{
+    // input blocked from the hook but not from raw input must not reinstall on every key
+    const uint64_t now = currentMicroseconds();
+    if (m_last_reinstall_time != 0 && now - m_last_reinstall_time < kReinstallInterval)
+        return;
+    m_last_reinstall_time = now;
+
+    const bool reinstalled = globalData()->keyboardHook()->reinstall();
+    metrics()->recordHookReinstall(reinstalled);
+    logIncident(health, now, reinstalled);
+}
+
+void HookWatchdog::logIncident(const HookHealth &health, uint64_t now, bool reinstalled) const
+{
+    const std::wstring file_path = programDir() + kHookIncidentFile;
+    std::wofstream file(file_path, std::ios::out | std::ios::app);
+    if (!file.is_open())
+        return;
+
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    wchar_t time_text[32];
+    swprintf_s(time_text, L"%04d-%02d-%02d %02d:%02d:%02d", time.wYear, time.wMonth, time.wDay,
+            time.wHour, time.wMinute, time.wSecond);
+
+    file << time_text << L" hook silent for " << kMissedKeyLimit << L" keys, last beat "
+            << (now - health.last_call_time) / 1000 << L"ms ago, "
+            << (reinstalled ? L"reinstalled" : L"reinstall failed") << L"\n";
+    // samples before the hook was removed, a slow one points to the path that timed out
+    file << L"  hook time before:";
+    const size_t count = health.calls < HookHealth::kRecentCount
+            ? static_cast<size_t>(health.calls) : HookHealth::kRecentCount;
+    for (size_t i = HookHealth::kRecentCount - count; i < HookHealth::kRecentCount; ++i)
+        file << L" " << health.recent_times[i] << L"us";
+    file << L"\n  " << metrics()->latencySummary() << L"\n";
+}
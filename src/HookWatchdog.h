@@ -0,0 +1,30 @@
+#pragma once
+
+#include "utils/HotkeyTable.h"
+
+#include <Windows.h>
+
+#include <cstdint>
+
+// Windows removes a low level hook without notice when it runs too long. keyboard raw input
+// is observed next to the hook, keys that arrive while the hook stops beating mean the hook
+// was removed and it is installed again. run on the thread that installed the hook
+class HookWatchdog
+{
+public:
+    static constexpr int kMissedKeyLimit = 3;
+    static constexpr uint64_t kReinstallInterval = 5000000;  // microseconds
+
+    // raw input of keyboard is sent to hwnd even when other windows have focus
+    bool initialize(HWND hwnd);
+    // WM_INPUT of hwnd
+    void handleInput(HRAWINPUT input);
+
+private:
+    void reinstallHook(const HookHealth &health);
+    void logIncident(const HookHealth &health, uint64_t now, bool reinstalled) const;
+
+    uint64_t m_last_hook_calls = 0;
+    int m_missed_keys = 0;
+    uint64_t m_last_reinstall_time = 0;
+};
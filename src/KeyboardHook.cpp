@@ -6,6 +6,8 @@ const wchar_t *kKeyboardDllFile = L"KeyboardListener.dll";
 KeyboardHook::~KeyboardHook()
 {
     m_hook.reset();
+    if (m_close_hotkey_table)
+        m_close_hotkey_table();
     m_dll.reset();
 }
 
@@ -17,14 +19,47 @@ bool KeyboardHook::initialize(HINSTANCE instance)
         return false;
 
     // find symbols
+    m_open_hotkey_table = reinterpret_cast<decltype(m_open_hotkey_table)>(
+            GetProcAddress(m_dll.get(), "openHotkeyTable"));
+    m_close_hotkey_table = reinterpret_cast<decltype(m_close_hotkey_table)>(
+            GetProcAddress(m_dll.get(), "closeHotkeyTable"));
     m_add_hotkey = reinterpret_cast<decltype(m_add_hotkey)>(
             GetProcAddress(m_dll.get(), "addHotkey"));
+    m_remove_hotkey = reinterpret_cast<decltype(m_remove_hotkey)>(
+            GetProcAddress(m_dll.get(), "removeHotkey"));
     m_mod_up_notify_once = reinterpret_cast<decltype(m_mod_up_notify_once)>(
             GetProcAddress(m_dll.get(), "modUpNotifyOnce"));
+    m_pop_hotkey = reinterpret_cast<decltype(m_pop_hotkey)>(
+            GetProcAddress(m_dll.get(), "popHotkey"));
+    m_hook_time = reinterpret_cast<decltype(m_hook_time)>(
+            GetProcAddress(m_dll.get(), "hookTime"));
+    m_hook_health = reinterpret_cast<decltype(m_hook_health)>(
+            GetProcAddress(m_dll.get(), "hookHealth"));
     m_hook_proc = reinterpret_cast<HOOKPROC>(GetProcAddress(m_dll.get(), "keyboardHookProc"));
-    if (!m_hook_proc || !m_add_hotkey || !m_mod_up_notify_once)
+    if (!m_hook_proc || !m_open_hotkey_table || !m_close_hotkey_table || !m_add_hotkey
+            || !m_remove_hotkey || !m_mod_up_notify_once || !m_pop_hotkey || !m_hook_time
+            || !m_hook_health)
         return false;
 
+    // outside of DllMain, the table is a named file mapping
+    if (!m_open_hotkey_table())
+        return false;
+
+    return install();
+}
+
+bool KeyboardHook::reinstall()
+{
+    if (!m_dll || !m_hook_proc)
+        return false;
+
+    // unhooking a removed hook only fails
+    m_hook.reset();
+    return install();
+}
+
+bool KeyboardHook::install()
+{
     // set hook
     m_hook = {
         SetWindowsHookEx(WH_KEYBOARD_LL, m_hook_proc, m_dll.get(), 0),
@@ -41,9 +76,38 @@ bool KeyboardHook::addHotkey(HWND hwnd, int id, UINT modifiers, UINT key)
     return m_add_hotkey(hwnd, id, modifiers, key);
 }
 
+bool KeyboardHook::removeHotkey(HWND hwnd, UINT modifiers, UINT key)
+{
+    if (!m_remove_hotkey || !hwnd)
+        return false;
+    return m_remove_hotkey(hwnd, modifiers, key);
+}
+
 bool KeyboardHook::modUpNotifyOnce(HWND hwnd, UINT modifiers)
 {
     if (!m_mod_up_notify_once || !hwnd)
         return false;
     return m_mod_up_notify_once(hwnd, modifiers);
 }
+
+bool KeyboardHook::popHotkey(HotkeyEvent *event)
+{
+    if (!m_pop_hotkey)
+        return false;
+    return m_pop_hotkey(event);
+}
+
+HookHealth KeyboardHook::health() const
+{
+    HookHealth health = {};
+    if (m_hook_health)
+        m_hook_health(&health);
+    return health;
+}
+
+const LatencyHistogram *KeyboardHook::hookTime() const
+{
+    if (!m_hook_time)
+        return nullptr;
+    return m_hook_time();
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "utils/HotkeyTable.h"
+#include "utils/LatencyHistogram.h"
+
 #include <Windows.h>
 
 #include <memory>
@@ -10,16 +13,32 @@ public:
     ~KeyboardHook();
 
     bool initialize(HINSTANCE instance);
+    // install again after Windows removed the hook, on the thread that installed it
+    bool reinstall();
 
     bool addHotkey(HWND hwnd, int id, UINT modifiers, UINT key);
+    // free a slot added by hwnd, the hook passes the key on again
+    bool removeHotkey(HWND hwnd, UINT modifiers, UINT key);
     bool modUpNotifyOnce(HWND hwnd, UINT modifiers);
+    // hotkeys are queued by the hook, take the next one after WMAPP_HOTKEY
+    bool popHotkey(HotkeyEvent *event);
+    const LatencyHistogram *hookTime() const;
+    HookHealth health() const;
 
 private:
+    bool install();
+
     std::unique_ptr<HINSTANCE__, decltype(&FreeLibrary)> m_dll = { nullptr, FreeLibrary };
     std::unique_ptr<HHOOK__, decltype(&UnhookWindowsHookEx)> m_hook = { nullptr, UnhookWindowsHookEx };
 
+    bool (*m_open_hotkey_table)() = nullptr;
+    void (*m_close_hotkey_table)() = nullptr;
     bool (*m_add_hotkey)(HWND hwnd, int id, UINT modifiers, UINT key) = nullptr;
+    bool (*m_remove_hotkey)(HWND hwnd, UINT modifiers, UINT key) = nullptr;
     bool (*m_mod_up_notify_once)(HWND hwnd, UINT modifiers) = nullptr;
+    bool (*m_pop_hotkey)(HotkeyEvent *event) = nullptr;
+    const LatencyHistogram *(*m_hook_time)() = nullptr;
+    void (*m_hook_health)(HookHealth *health) = nullptr;
     HOOKPROC m_hook_proc = nullptr;
 };
 
@@ -1,8 +1,11 @@
 #include "LayoutItem.h"
 #include "GlobalData.h"
+#include "SnapshotCache.h"
 #include "UIParam.h"
 #include "WindowHandle.h"
 
+#include <cmath>
+
 SizeF LayoutItem::scaledSize(REAL width, REAL height, REAL width_limit, REAL height_limit,
         REAL bar_height)
 {
@@ -26,7 +29,8 @@ LayoutItem::LayoutItem(WindowHandle *window, const RectF &rect, const REAL bar_h
     // align thumbnail rect
     const RectF &window_rect = window->rect();
     SizeF thumbnail_size = { 0, rect.Height - bar_height };
-    thumbnail_size.Width = thumbnail_size.Height * (window_rect.Width / window_rect.Height);
+    if (thumbnail_size.Height > 0 && window_rect.Height > 0)
+        thumbnail_size.Width = thumbnail_size.Height * (window_rect.Width / window_rect.Height);
     m_thumbnail_rect = {
         m_rect.X + (m_rect.Width - thumbnail_size.Width) / 2, m_rect.Y + bar_height,
         thumbnail_size.Width, thumbnail_size.Height
@@ -35,11 +39,6 @@ LayoutItem::LayoutItem(WindowHandle *window, const RectF &rect, const REAL bar_h
     const UIParam *ui = globalData()->UI();
     m_icon_rect = { m_rect.X, m_rect.Y, bar_height, bar_height };
     m_icon_rect.Inflate(-ui->itemIconMargin(), -ui->itemIconMargin());
-
-    // initialize icon bitmap data
-    HICON icon = m_window->icon();
-    if (icon)
-        m_icon_bitmap = decltype(m_icon_bitmap)(Bitmap::FromHICON(icon));
 }
 
 void LayoutItem::setPosition(const PointF &pos)
@@ -50,21 +49,74 @@ void LayoutItem::setPosition(const PointF &pos)
     m_icon_rect.Offset(offset);
 }
 
-void LayoutItem::drawInfo(Graphics *graphics) const
+bool LayoutItem::usesSnapshot() const
+{
+    if (m_snapshot_bitmap)
+        return true;
+    SnapshotCache *cache = globalData()->snapshotCache();
+    return cache && m_window->minimized() && cache->contains(m_window->hwnd());
+}
+
+void LayoutItem::loadDetails() const
+{
+    if (m_details_loaded)
+        return;
+    m_details_loaded = true;
+
+    // initialize icon bitmap data
+    m_window->loadIcon();
+    HICON icon = m_window->icon();
+    if (icon)
+        m_icon_bitmap = decltype(m_icon_bitmap)(Bitmap::FromHICON(icon));
+
+    SnapshotCache *cache = globalData()->snapshotCache();
+    if (cache && hasThumbnail() && m_window->minimized())
+        m_snapshot_bitmap = cache->load(m_window->hwnd());
+}
+
+void LayoutItem::unloadDetails() const
+{
+    m_icon_bitmap.reset();
+    m_snapshot_bitmap.reset();
+    m_details_loaded = false;
+}
+
+void LayoutItem::drawInfo(Graphics *graphics, const PixelSurface &pixels) const
 {
     if (!graphics)
         return;
 
     const UIParam *ui = globalData()->UI();
 
-    // draw background
-    Gdiplus::SolidBrush back_brush{Gdiplus::Color(ui->itemBackgroundColor())};
-    graphics->FillRectangle(&back_brush, m_rect);
+    // draw background, previous GDI+ drawing must reach the pixels first
+    graphics->Flush(Gdiplus::FlushIntentionSync);
+    PixelCompositor::blend(pixels,
+            std::lround(m_rect.X), std::lround(m_rect.Y),
+            std::lround(m_rect.GetRight()), std::lround(m_rect.GetBottom()),
+            PixelCompositor::premultiply(ui->itemBackgroundColor()));
+
+    if (!m_details_loaded)
+        return;
 
     // draw icon
     if (m_icon_bitmap)
         graphics->DrawImage(m_icon_bitmap.get(), m_icon_rect);
 
+    if (m_snapshot_bitmap) {
+        // snapshot of minimized window takes the place of its thumbnail
+        graphics->DrawImage(m_snapshot_bitmap.get(), m_thumbnail_rect);
+    } else if (m_icon_bitmap && hasThumbnail()) {
+        // larger icon as placeholder under the live thumbnail
+        const REAL size = min(min(m_thumbnail_rect.Width, m_thumbnail_rect.Height) * 0.4f,
+                m_icon_rect.Width * 2);
+        const RectF placeholder_rect = {
+            m_thumbnail_rect.X + (m_thumbnail_rect.Width - size) / 2,
+            m_thumbnail_rect.Y + (m_thumbnail_rect.Height - size) / 2,
+            size, size
+        };
+        graphics->DrawImage(m_icon_bitmap.get(), placeholder_rect);
+    }
+
     // draw title
     Gdiplus::StringFormat format(Gdiplus::StringFormat::GenericTypographic());
     format.SetTrimming(Gdiplus::StringTrimming::StringTrimmingEllipsisCharacter);
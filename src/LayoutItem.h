@@ -1,5 +1,7 @@
 #pragma once
 
+#include "utils/PixelCompositor.h"
+
 #include <Windows.h>
 #include <gdiplus.h>
 
@@ -23,10 +25,20 @@ public:
     const WindowHandle *windowHandle() const { return m_window; }
     const RectF &rect() const { return m_rect; }
     RectF thumbnailRect() const { return m_thumbnail_rect; }
+    bool detailsLoaded() const { return m_details_loaded; }
+    // items of compact layout show only icon and title
+    bool hasThumbnail() const { return !m_thumbnail_rect.IsEmptyArea(); }
+    // minimized window is drawn from its snapshot instead of a live thumbnail
+    bool usesSnapshot() const;
 
     void setPosition(const PointF &pos);
+    // load icon and show title, items are drawn as plain frames until then
+    void loadDetails() const;
+    // release icon and snapshot bitmaps, the item is drawn as a plain frame again
+    void unloadDetails() const;
 
-    void drawInfo(Graphics *graphics) const;
+    // background is filled into pixels, icon and title are drawn by graphics
+    void drawInfo(Graphics *graphics, const PixelSurface &pixels) const;
 
     static SizeF scaledSize(REAL cx, REAL cy, REAL width_limit, REAL height_limit,
             REAL bar_height);
@@ -36,6 +48,8 @@ private:
     RectF m_rect;
     RectF m_thumbnail_rect;
     REAL m_bar_height = 0;
-    std::unique_ptr<Bitmap> m_icon_bitmap = nullptr;
+    mutable std::unique_ptr<Bitmap> m_icon_bitmap = nullptr;
+    mutable std::unique_ptr<Bitmap> m_snapshot_bitmap = nullptr;
+    mutable bool m_details_loaded = false;
     RectF m_icon_rect;
 };
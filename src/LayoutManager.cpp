@@ -288,3 +288,140 @@ const LayoutItem *ListLayoutManager::getPrevItem(const LayoutItem *item) const
     // should never happen
     return nullptr;
 }
+
+// --------------------CompactLayoutManager---------------------
+
+// index of the cell containing offset, cells before the first one count as the first
+static size_t cellIndex(REAL offset, REAL pitch)
+{
+    return offset > 0 ? static_cast<size_t>(offset / pitch) : 0;
+}
+
+CompactLayoutManager::CompactLayoutManager(HMONITOR monitor, REAL width_limit, bool list_items)
+    : LayoutManager(monitor, width_limit), m_list_items(list_items)
+{
+    updateCells();
+}
+
+void CompactLayoutManager::reinitialize(HMONITOR monitor, REAL width_limit)
+{
+    LayoutManager::reinitialize(monitor, width_limit);
+    m_items.clear();
+    // scale of UI may differ between monitors
+    updateCells();
+}
+
+void CompactLayoutManager::updateCells()
+{
+    const UIParam *ui = globalData()->UI();
+
+    m_cell_size = m_list_items
+            ? SizeF(ui->listItemMaxWidth(), ui->listBarHeight())
+            : SizeF(ui->gridItemMaxWidth(), ui->gridBarHeight());
+    // leave room for select frame between cells
+    m_spacing = ui->selectFrameMargin() + ui->selectFrameWidth();
+
+    const REAL usable_width = m_width_limit - ui->gridEdgeHMargin() * 2 + m_spacing;
+    m_columns = max(cellIndex(usable_width, m_cell_size.Width + m_spacing), static_cast<size_t>(1));
+}
+
+size_t CompactLayoutManager::indexOf(const LayoutItem *item) const
+{
+    if (!item || m_items.empty() || item < &m_items.front() || item > &m_items.back())
+        return m_items.size();
+    return item - &m_items.front();
+}
+
+const LayoutItem *CompactLayoutManager::itemAt(size_t index) const
+{
+    if (index >= m_items.size())
+        return nullptr;
+    return &m_items[index];
+}
+
+std::vector<const LayoutItem *> CompactLayoutManager::intersectItems(const RectF &rect) const
+{
+    std::vector<const LayoutItem *> ret;
+    if (rect.IsEmptyArea() || m_items.empty())
+        return ret;
+
+    // visit only cells under rect
+    const UIParam *ui = globalData()->UI();
+    const REAL pitch_x = m_cell_size.Width + m_spacing;
+    const REAL pitch_y = m_cell_size.Height + m_spacing;
+    const size_t rows = (m_items.size() + m_columns - 1) / m_columns;
+    const size_t first_row = cellIndex(rect.Y - ui->gridEdgeVMargin(), pitch_y);
+    const size_t last_row = min(cellIndex(rect.GetBottom() - ui->gridEdgeVMargin(), pitch_y),
+            rows - 1);
+    const size_t first_col = cellIndex(rect.X - ui->gridEdgeHMargin(), pitch_x);
+    const size_t last_col = min(cellIndex(rect.GetRight() - ui->gridEdgeHMargin(), pitch_x),
+            m_columns - 1);
+
+    for (size_t row = first_row; row <= last_row; ++row) {
+        for (size_t col = first_col; col <= last_col; ++col) {
+            const size_t index = row * m_columns + col;
+            if (index >= m_items.size())
+                break;
+            if (m_items[index].rect().IntersectsWith(rect))
+                ret.push_back(&m_items[index]);
+        }
+    }
+    return ret;
+}
+
+const LayoutItem *CompactLayoutManager::itemFromPoint(const PointF &point) const
+{
+    // get item from 1x1 rect based on point
+    const auto items = intersectItems(RectF(point, SizeF(1, 1)));
+    return items.empty() ? nullptr : items.front();
+}
+
+const LayoutItem *CompactLayoutManager::getNextItem(const LayoutItem *item) const
+{
+    const size_t index = indexOf(item);
+    if (index == m_items.size())
+        return nullptr;
+    return &m_items[(index + 1) % m_items.size()];
+}
+
+const LayoutItem *CompactLayoutManager::getPrevItem(const LayoutItem *item) const
+{
+    const size_t index = indexOf(item);
+    if (index == m_items.size())
+        return nullptr;
+    return &m_items[(index + m_items.size() - 1) % m_items.size()];
+}
+
+void CompactLayoutManager::addItem(WindowHandle *window)
+{
+    const UIParam *ui = globalData()->UI();
+
+    // attributes of the last update are enough without thumbnail
+    const size_t index = m_items.size();
+    const RectF rect = {
+        ui->gridEdgeHMargin() + (index % m_columns) * (m_cell_size.Width + m_spacing),
+        ui->gridEdgeVMargin() + (index / m_columns) * (m_cell_size.Height + m_spacing),
+        m_cell_size.Width, m_cell_size.Height
+    };
+    // the bar takes the whole cell
+    m_items.emplace_back(window, rect, m_cell_size.Height);
+}
+
+void CompactLayoutManager::alignItems()
+{
+    const UIParam *ui = globalData()->UI();
+
+    if (m_items.empty()) {
+        m_rect = { 0, 0, 0, 0 };
+        return;
+    }
+
+    const size_t columns = min(m_items.size(), m_columns);
+    const size_t rows = (m_items.size() + m_columns - 1) / m_columns;
+    m_widest = columns * (m_cell_size.Width + m_spacing) - m_spacing;
+    m_rect = {
+        0, 0,
+        m_widest + ui->gridEdgeHMargin() * 2,
+        rows * (m_cell_size.Height + m_spacing) - m_spacing + ui->gridEdgeVMargin() * 2
+    };
+}
@@ -74,3 +74,33 @@ public:
 private:
     std::vector<LayoutItem> m_items;
 };
+
+// cells of icon and title without thumbnail, all of one size so that positions and
+// lookups are computed from indices regardless of the number of items
+class CompactLayoutManager : public LayoutManager
+{
+public:
+    CompactLayoutManager(HMONITOR monitor, REAL width_limit, bool list_items);
+
+    void reinitialize(HMONITOR monitor, REAL width_limit) override;
+
+    const LayoutItem *itemAt(size_t index) const override;
+    std::vector<const LayoutItem *> intersectItems(const RectF &rect) const override;
+    const LayoutItem *itemFromPoint(const PointF &point) const override;
+    const LayoutItem *getNextItem(const LayoutItem *item) const override;
+    const LayoutItem *getPrevItem(const LayoutItem *item) const override;
+
+    void addItem(WindowHandle *window) override;
+    void alignItems() override;
+
+private:
+    void updateCells();
+    // index of item in m_items, size of m_items if not found
+    size_t indexOf(const LayoutItem *item) const;
+
+    bool m_list_items;  // cells as wide as list items instead of grid items
+    SizeF m_cell_size;
+    REAL m_spacing = 0;
+    size_t m_columns = 1;
+    std::vector<LayoutItem> m_items;
+};
@@ -1,16 +1,26 @@
 #include "MainWindow.h"
+#include "ConfigWatcher.h"
 #include "Configure.h"
 #include "GlobalData.h"
+#include "HighlightWindow.h"
+#include "HookWatchdog.h"
 #include "KeyboardHook.h"
+#include "Metrics.h"
+#include "RenderThread.h"
 #include "resource.h"
 #include "ThumbnailWindow.h"
+#include "utils/ProgramUtils.h"
 
 #include <CommCtrl.h>
 
+#include <cstring>
+
 #pragma comment(linker,"/manifestdependency:\"type='win32' name='Microsoft.Windows.Common-Controls' \
         version='6.0.0.0' processorArchitecture='*' publicKeyToken='6595b64144ccf1df' language='*'\"")
 #pragma comment(lib, "comctl32.lib")
 
+const wchar_t *kStatisticsFile = L"statistics.txt";
+
 static HMONITOR monitorFromActiveWindow()
 {
     HWND hwnd = GetForegroundWindow();
@@ -43,27 +53,15 @@ bool MainWindow::create(HINSTANCE instance)
         return false;
     }
 
-    KeyboardHook *hook = globalData()->keyboardHook();
-    bool success = true;
-
     // add hotkeys
-#define REGISTER_HELPER(id, key, enable_prev, prev_id) \
-    if (key != 0) success &= hook->addHotkey(m_hwnd.get(), id, MOD_ALT, key); \
-    if (enable_prev) success &= hook->addHotkey(m_hwnd.get(), prev_id, MOD_ALT | MOD_SHIFT, key); \
-    if (!success) return false
-
-    REGISTER_HELPER(HotkeyID::HotkeyIDSwitchGroup, config()->switchGroupkey(),
-            config()->enablePrevGroupHotkey(), HotkeyID::HotkeyIDSwitchPrevGroup);
-    REGISTER_HELPER(HotkeyID::HotkeyIDSwitchWindow, config()->switchWindowkey(),
-            config()->enablePrevWindowHotkey(), HotkeyID::HotkeyIDSwitchPrevWindow);
-    REGISTER_HELPER(HotkeyID::HotkeyIDSwitchMonitor, config()->switchMonitorkey(),
-            config()->enablePrevMonitorHotkey(), HotkeyID::HotkeyIDSwitchPrevMonitor);
-#undef REGISTER_HELPER
-
-    const Configure::HotkeyPair &hotkey_pair = config()->keepShowingHotkey();
-    if (hotkey_pair.first != 0 && hotkey_pair.second != 0) {
-        if (!hook->addHotkey(m_hwnd.get(), HotkeyID::HotkeyIDKeepShowingWindow,
-                hotkey_pair.first, hotkey_pair.second))
+    const Configure::Settings &settings = config()->settings();
+    static_assert(HotkeyID::HotkeyIDPinnedWindowLast - HotkeyID::HotkeyIDPinnedWindowFirst + 1
+            == Configure::kPinnedWindowCount, "one hotkey id per pinned window");
+    for (size_t i = 0; i < Configure::kPinnedWindowCount; ++i)
+        m_pinned_windows.emplace_back(settings.pinned_windows[i]);
+    KeyboardHook *hook = globalData()->keyboardHook();
+    for (const HotkeyBinding &binding : hotkeyBindings(settings)) {
+        if (!hook->addHotkey(m_hwnd.get(), binding.id, binding.modifiers, binding.key))
             return false;
     }
 
@@ -84,11 +82,85 @@ bool MainWindow::create(HINSTANCE instance)
     m_tray_menu = { CreatePopupMenu(), DestroyMenu };
     if (!m_tray_menu)
         return false;
+    AppendMenu(m_tray_menu.get(), MF_STRING, kTrayMenuStatisticsID, L"Statistics");
+    AppendMenu(m_tray_menu.get(), MF_STRING, kTrayMenuExportStatisticsID, L"Export Statistics");
+    AppendMenu(m_tray_menu.get(), MF_SEPARATOR, 0, nullptr);
     AppendMenu(m_tray_menu.get(), MF_STRING, kTrayMenuExitID, L"Exit");
 
     return true;
 }
 
+bool MainWindow::updateHotkeys(const Configure::Settings &previous,
+        const Configure::Settings &settings)
+{
+    KeyboardHook *hook = globalData()->keyboardHook();
+    const std::vector<HotkeyBinding> previous_bindings = hotkeyBindings(previous);
+    const std::vector<HotkeyBinding> bindings = hotkeyBindings(settings);
+    auto contains = [](const std::vector<HotkeyBinding> &list, const HotkeyBinding &binding) {
+        return std::find(list.begin(), list.end(), binding) != list.end();
+    };
+
+    // free slots first, hotkeys may swap their keys
+    for (const HotkeyBinding &binding : previous_bindings) {
+        if (!contains(bindings, binding))
+            hook->removeHotkey(m_hwnd.get(), binding.modifiers, binding.key);
+    }
+    bool success = true;
+    for (const HotkeyBinding &binding : bindings) {
+        if (!contains(previous_bindings, binding))
+            success &= hook->addHotkey(m_hwnd.get(), binding.id, binding.modifiers, binding.key);
+    }
+
+    // unchanged pins keep their found windows
+    for (size_t i = 0; i < Configure::kPinnedWindowCount; ++i) {
+        if (std::strcmp(previous.pinned_windows[i], settings.pinned_windows[i]) != 0)
+            m_pinned_windows[i] = PinnedWindow(settings.pinned_windows[i]);
+    }
+    return success;
+}
+
+std::vector<MainWindow::HotkeyBinding> MainWindow::hotkeyBindings(
+        const Configure::Settings &settings)
+{
+    std::vector<HotkeyBinding> bindings;
+
+#define BINDING_HELPER(id, key, enable_prev, prev_id) \
+    if (key != 0) bindings.push_back({ id, MOD_ALT, key }); \
+    if (enable_prev) bindings.push_back({ prev_id, MOD_ALT | MOD_SHIFT, key })
+
+    BINDING_HELPER(HotkeyID::HotkeyIDSwitchGroup, settings.switch_group_key,
+            settings.enable_prev_group_hotkey, HotkeyID::HotkeyIDSwitchPrevGroup);
+    BINDING_HELPER(HotkeyID::HotkeyIDSwitchWindow, settings.switch_window_key,
+            settings.enable_prev_window_hotkey, HotkeyID::HotkeyIDSwitchPrevWindow);
+    BINDING_HELPER(HotkeyID::HotkeyIDSwitchMonitor, settings.switch_monitor_key,
+            settings.enable_prev_monitor_hotkey, HotkeyID::HotkeyIDSwitchPrevMonitor);
+#undef BINDING_HELPER
+
+    const Configure::HotkeyPair &hotkey_pair = settings.keep_showing_hotkey;
+    if (hotkey_pair.first != 0 && hotkey_pair.second != 0) {
+        bindings.push_back({ HotkeyID::HotkeyIDKeepShowingWindow,
+                hotkey_pair.first, hotkey_pair.second });
+    }
+
+    if (settings.enable_group_jump_hotkeys) {
+        for (int i = HotkeyID::HotkeyIDJumpGroupFirst; i <= HotkeyID::HotkeyIDJumpGroupLast; ++i) {
+            const UINT key = '1' + i - HotkeyID::HotkeyIDJumpGroupFirst;
+            bindings.push_back({ i, MOD_ALT, key });
+        }
+    }
+
+    for (size_t i = 0; i < Configure::kPinnedWindowCount; ++i) {
+        const Configure::HotkeyPair &pinned_hotkey = settings.pinned_window_hotkeys[i];
+        if (pinned_hotkey.first == 0 || pinned_hotkey.second == 0
+                || PinnedWindow(settings.pinned_windows[i]).empty())
+            continue;
+        bindings.push_back({ static_cast<int>(HotkeyID::HotkeyIDPinnedWindowFirst + i),
+                pinned_hotkey.first, pinned_hotkey.second });
+    }
+
+    return bindings;
+}
+
 LRESULT MainWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
     if (hwnd != m_hwnd.get())
@@ -105,6 +177,12 @@ LRESULT MainWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lP
         if (LOWORD(wParam) == kTrayMenuExitID) {
             PostQuitMessage(0);
             return 0;
+        } else if (LOWORD(wParam) == kTrayMenuStatisticsID) {
+            showStatistics();
+            return 0;
+        } else if (LOWORD(wParam) == kTrayMenuExportStatisticsID) {
+            exportStatistics();
+            return 0;
         }
         break;
 
@@ -121,26 +199,37 @@ LRESULT MainWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lP
         }
         break;
 
+    case WM_INPUT:
+        // raw input is cleaned up by DefWindowProc
+        if (globalData()->hookWatchdog())
+            globalData()->hookWatchdog()->handleInput(reinterpret_cast<HRAWINPUT>(lParam));
+        break;
+
+    case WMAPP_CONFIGCHANGED:
+        if (globalData()->configWatcher())
+            globalData()->configWatcher()->reload();
+        return 0;
+
     case WMAPP_HOTKEY:
-        switch (static_cast<HotkeyID>(wParam)) {
-        case HotkeyID::HotkeyIDSwitchGroup:
-        case HotkeyID::HotkeyIDSwitchPrevGroup:
-            handleSwitchGroup(static_cast<HotkeyID>(wParam));
-            break;
-
-        case HotkeyID::HotkeyIDSwitchWindow:
-        case HotkeyID::HotkeyIDSwitchPrevWindow:
-            handleSwitchWindow(static_cast<HotkeyID>(wParam));
-            break;
-
-        case HotkeyID::HotkeyIDSwitchMonitor:
-        case HotkeyID::HotkeyIDSwitchPrevMonitor:
-            handleSwitchMonitor(static_cast<HotkeyID>(wParam));
-            break;
-
-        case HotkeyID::HotkeyIDKeepShowingWindow:
-            handleShowWindow(static_cast<HotkeyID>(wParam));
-            break;
+        {
+            // drain hotkeys queued since the wake, each is handed over to render thread
+            HotkeyEvent event;
+            while (globalData()->keyboardHook()->popHotkey(&event)) {
+                metrics()->stage(Metrics::StageDispatch).record(currentMicroseconds() - event.time);
+                const HotkeyID kid = static_cast<HotkeyID>(event.id);
+                if (kid >= HotkeyID::HotkeyIDPinnedWindowFirst
+                        && kid <= HotkeyID::HotkeyIDPinnedWindowLast) {
+                    activatePinnedWindow(kid, event.time);
+                    continue;
+                }
+                const HMONITOR monitor = kid == HotkeyID::HotkeyIDKeepShowingWindow
+                        ? monitorFromCursor() : monitorFromActiveWindow();
+                const uint64_t key_time = event.time;
+                globalData()->renderThread()->post([this, kid, monitor, key_time]() {
+                    metrics()->beginKeyEvent(key_time);
+                    handleHotkey(kid, monitor);
+                });
+            }
         }
         return 0;
 
@@ -150,16 +239,97 @@ LRESULT MainWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lP
     return -1;
 }
 
-void MainWindow::handleSwitchGroup(HotkeyID kid)
+void MainWindow::showStatistics()
+{
+    // modal loop keeps serving the hook
+    const std::wstring report = metrics()->report();
+    MessageBox(m_hwnd.get(), report.c_str(), L"GroupTabBox Statistics", MB_OK | MB_ICONINFORMATION);
+}
+
+void MainWindow::exportStatistics()
+{
+    const std::wstring file_path = programDir() + kStatisticsFile;
+    if (metrics()->exportReport(file_path)) {
+        const std::wstring text = L"Statistics are exported to " + file_path;
+        MessageBox(m_hwnd.get(), text.c_str(), L"GroupTabBox Statistics", MB_OK | MB_ICONINFORMATION);
+    } else {
+        MessageBox(m_hwnd.get(), L"Failed to export statistics", L"GroupTabBox Statistics",
+                MB_OK | MB_ICONERROR);
+    }
+}
+
+void MainWindow::activatePinnedWindow(HotkeyID kid, uint64_t key_time)
+{
+    HWND hwnd = m_pinned_windows[kid - HotkeyID::HotkeyIDPinnedWindowFirst].resolve();
+    if (!hwnd)
+        return;
+
+    metrics()->pinnedActivation().record(currentMicroseconds() - key_time);
+    WindowHandle::activate(hwnd);
+
+    // shown views are hidden, hidden views are rendered again for the new z-order
+    globalData()->renderThread()->post([]() {
+        globalData()->activateWindow(nullptr);
+    });
+}
+
+void MainWindow::handleHotkey(HotkeyID kid, HMONITOR monitor)
+{
+    // other hotkeys replace a group view waiting for the show delay
+    GroupThumbnailWindow *group = globalData()->groupWindow();
+    if (group && kid != HotkeyID::HotkeyIDSwitchGroup && kid != HotkeyID::HotkeyIDSwitchPrevGroup)
+        group->cancelPendingShow();
+
+    switch (kid) {
+    case HotkeyID::HotkeyIDSwitchGroup:
+    case HotkeyID::HotkeyIDSwitchPrevGroup:
+        handleSwitchGroup(kid, monitor);
+        break;
+
+    case HotkeyID::HotkeyIDSwitchWindow:
+    case HotkeyID::HotkeyIDSwitchPrevWindow:
+        handleSwitchWindow(kid, monitor);
+        break;
+
+    case HotkeyID::HotkeyIDSwitchMonitor:
+    case HotkeyID::HotkeyIDSwitchPrevMonitor:
+        handleSwitchMonitor(kid, monitor);
+        break;
+
+    case HotkeyID::HotkeyIDKeepShowingWindow:
+        handleShowWindow(kid, monitor);
+        break;
+
+    default:
+        if (kid >= HotkeyID::HotkeyIDJumpGroupFirst && kid <= HotkeyID::HotkeyIDJumpGroupLast)
+            handleJumpGroup(kid, monitor);
+        break;
+    }
+
+    // the first present of a shown view ends the key event, with no view shown the
+    // command presents nothing and later frames belong to other input
+    ListThumbnailWindow *list = globalData()->listWindow();
+    if (!(group && group->visible()) && !(list && list->visible()))
+        metrics()->endKeyEvent();
+}
+
+void MainWindow::handleSwitchGroup(HotkeyID kid, HMONITOR monitor)
 {
     GroupThumbnailWindow *group = globalData()->groupWindow();
     if (!group)
         return;
 
     if (!group->visible()) {
-        if (!globalData()->update(monitorFromActiveWindow()))
+        if (group->showPending()) {
+            // pressed again within the show delay
+            group->showPendingNow();
+        } else if (kid == HotkeyID::HotkeyIDSwitchGroup && group->showDelayed(monitor)) {
             return;
-        group->show(false);
+        } else {
+            if (!globalData()->update(monitor))
+                return;
+            group->show(false);
+        }
     }
 
     if (group->visible()) {
@@ -171,14 +341,14 @@ void MainWindow::handleSwitchGroup(HotkeyID kid)
     }
 }
 
-void MainWindow::handleSwitchWindow(HotkeyID kid)
+void MainWindow::handleSwitchWindow(HotkeyID kid, HMONITOR monitor)
 {
     ListThumbnailWindow *list = globalData()->listWindow();
     if (!list)
         return;
 
     if (!list->visible()) {
-        if (!globalData()->update(monitorFromActiveWindow()))
+        if (!globalData()->update(monitor))
             return;
 
         // show the group of the active window
@@ -205,7 +375,7 @@ void MainWindow::handleSwitchWindow(HotkeyID kid)
     }
 }
 
-void MainWindow::handleSwitchMonitor(HotkeyID kid)
+void MainWindow::handleSwitchMonitor(HotkeyID kid, HMONITOR monitor)
 {
     GroupThumbnailWindow *group = globalData()->groupWindow();
     ListThumbnailWindow *list = globalData()->listWindow();
@@ -213,7 +383,7 @@ void MainWindow::handleSwitchMonitor(HotkeyID kid)
         return;
 
     if (!group->visible() || !list->visible()) {
-        if (!globalData()->update(monitorFromActiveWindow()))
+        if (!globalData()->update(monitor))
             return;
     }
 
@@ -239,11 +409,11 @@ void MainWindow::handleSwitchMonitor(HotkeyID kid)
         globalData()->setCurrentMonitor(monitors[(index - 1 + monitors.size()) % monitors.size()]);
     }
 
+    // list window is shown by group window after its first frame
     group->show(false);
-    list->show(false);
 }
 
-void MainWindow::handleShowWindow(HotkeyID kid)
+void MainWindow::handleShowWindow(HotkeyID kid, HMONITOR monitor)
 {
     GroupThumbnailWindow *group = globalData()->groupWindow();
     ListThumbnailWindow *list = globalData()->listWindow();
@@ -251,13 +421,41 @@ void MainWindow::handleShowWindow(HotkeyID kid)
         return;
 
     if (!group->visible() && !list->visible()) {
-        if (!globalData()->update(monitorFromCursor()))
+        if (!globalData()->update(monitor))
             return;
         group->show(true);
-        list->show(true);
     }
     if (group->visible())
         group->keepShowing(true);
     if (list->visible())
         list->keepShowing(true);
 }
+
+void MainWindow::handleJumpGroup(HotkeyID kid, HMONITOR monitor)
+{
+    const size_t index = kid - HotkeyID::HotkeyIDJumpGroupFirst;
+
+    // groups of the last snapshot, enumerated again only if it has no such group
+    const WindowHandle *window = globalData()->windowOfGroupAt(monitor, index);
+    if (!window || !IsWindow(window->hwnd())) {
+        // the jump hides shown views anyway, hide them first so that they release their
+        // layouts before the windows they refer to are enumerated again
+        GroupThumbnailWindow *group = globalData()->groupWindow();
+        ListThumbnailWindow *list = globalData()->listWindow();
+        if (group)
+            group->hide();
+        if (list)
+            list->hide();
+        if (!globalData()->update(monitor))
+            return;
+        window = globalData()->windowOfGroupAt(monitor, index);
+        if (!window)
+            return;
+    }
+
+    const HWND hwnd = window->hwnd();
+    globalData()->activateWindow(window);
+    HighlightWindow *highlight = globalData()->highlightWindow();
+    if (config()->highlightJumpTarget() && highlight && !IsIconic(hwnd))
+        highlight->flash(hwnd);
+}
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "Configure.h"
+#include "PinnedWindow.h"
+
 #include <Windows.h>
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 class MainWindow
 {
@@ -12,6 +17,9 @@ public:
     bool create(HINSTANCE instance);
 
     LRESULT handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+    // register only hotkeys and pinned windows differing from previous, on message thread.
+    // false if a hotkey is taken
+    bool updateHotkeys(const Configure::Settings &previous, const Configure::Settings &settings);
 
 private:
     // events id
@@ -24,15 +32,43 @@ private:
         HotkeyIDSwitchMonitor,
         HotkeyIDSwitchPrevMonitor,
         HotkeyIDKeepShowingWindow,
+        HotkeyIDJumpGroupFirst,  // ALT+1 to ALT+9
+        HotkeyIDJumpGroupLast = HotkeyIDJumpGroupFirst + 8,
+        HotkeyIDPinnedWindowFirst,
+        HotkeyIDPinnedWindowLast = HotkeyIDPinnedWindowFirst + 3,
         HotkeyIDNumber
     };
 
-    void handleSwitchGroup(HotkeyID kid);
-    void handleSwitchWindow(HotkeyID kid);
-    void handleSwitchMonitor(HotkeyID kid);
-    void handleShowWindow(HotkeyID kid);
+    struct HotkeyBinding
+    {
+        int id;
+        UINT modifiers;
+        UINT key;
+
+        bool operator==(const HotkeyBinding &other) const
+        {
+            return id == other.id && modifiers == other.modifiers && key == other.key;
+        }
+    };
+    // hotkeys in the hook table for settings
+    static std::vector<HotkeyBinding> hotkeyBindings(const Configure::Settings &settings);
+
+    // tray menu, run on message thread
+    void showStatistics();
+    void exportStatistics();
+    // no view is involved, the window is activated on message thread at once
+    void activatePinnedWindow(HotkeyID kid, uint64_t key_time);
+
+    // run on render thread, monitor is taken when the hotkey is pressed
+    void handleHotkey(HotkeyID kid, HMONITOR monitor);
+    void handleSwitchGroup(HotkeyID kid, HMONITOR monitor);
+    void handleSwitchWindow(HotkeyID kid, HMONITOR monitor);
+    void handleSwitchMonitor(HotkeyID kid, HMONITOR monitor);
+    void handleShowWindow(HotkeyID kid, HMONITOR monitor);
+    void handleJumpGroup(HotkeyID kid, HMONITOR monitor);
 
     std::unique_ptr<HWND__, decltype(&DestroyWindow)> m_hwnd =  { nullptr, DestroyWindow };
     std::unique_ptr<HMENU__, decltype(&DestroyMenu)> m_tray_menu = { nullptr, DestroyMenu };
+    std::vector<PinnedWindow> m_pinned_windows;  // indexed by hotkey id from the first pin
 };
 
@@ -0,0 +1,155 @@
+#include "Metrics.h"
+
+#include <Psapi.h>
+
+#include <fstream>
+#include <sstream>
+
+#pragma comment(lib, "psapi.lib")
+
+static void appendHistogram(std::wostringstream &stream, const wchar_t *name,
+        const LatencyHistogram &histogram, const wchar_t *unit = L"us")
+{
+    stream << name << L": n=" << histogram.count()
+            << L" p50=" << histogram.percentile(50) << unit
+            << L" p99=" << histogram.percentile(99) << unit
+            << L" max=" << histogram.maxValue() << unit << L"\n";
+}
+
+static const wchar_t *stageName(Metrics::Stage stage)
+{
+    switch (stage) {
+    case Metrics::StageDispatch:
+        return L"key to dispatch";
+    case Metrics::StageSnapshot:
+        return L"key to snapshot";
+    case Metrics::StageLayout:
+        return L"key to layout";
+    case Metrics::StageDraw:
+        return L"key to draw";
+    case Metrics::StagePresent:
+        return L"key to present";
+    default:
+        return L"";
+    }
+}
+
+uint64_t currentMicroseconds()
+{
+    static LARGE_INTEGER frequency = {};
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // split to avoid overflow of counter * 1000000
+    const uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+    const uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000 + remainder * 1000000 / frequency.QuadPart;
+}
+
+size_t currentWorkingSet()
+{
+    PROCESS_MEMORY_COUNTERS counters = { sizeof(counters) };
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.WorkingSetSize;
+}
+
+Metrics *metrics()
+{
+    return Metrics::instance();
+}
+
+Metrics *Metrics::instance()
+{
+    static Metrics instance;
+    return &instance;
+}
+
+void Metrics::recordTrim(int tier, size_t before, size_t after)
+{
+    if (tier < 0 || tier >= kTrimTierCount)
+        return;
+    m_trims[tier].count.fetch_add(1, std::memory_order_relaxed);
+    m_trims[tier].before.store(before, std::memory_order_relaxed);
+    m_trims[tier].after.store(after, std::memory_order_relaxed);
+}
+
+void Metrics::beginKeyEvent(uint64_t key_time)
+{
+    m_key_time = key_time;
+    m_marked_stages = 0;
+}
+
+void Metrics::markStage(Stage stage)
+{
+    const unsigned bit = 1u << stage;
+    if (m_key_time == 0 || (m_marked_stages & bit))
+        return;
+
+    m_marked_stages |= bit;
+    m_stages[stage].record(currentMicroseconds() - m_key_time);
+    // photon ends the key event
+    if (stage == StagePresent)
+        m_key_time = 0;
+}
+
+void Metrics::recordHookReinstall(bool success)
+{
+    m_hook_reinstalls.fetch_add(1, std::memory_order_relaxed);
+    if (!success)
+        m_failed_hook_reinstalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::wstring Metrics::report() const
+{
+    std::wostringstream stream;
+    if (m_hook_time)
+        appendHistogram(stream, L"hook time", *m_hook_time);
+    for (int stage = 0; stage < StageNumber; ++stage)
+        appendHistogram(stream, stageName(static_cast<Stage>(stage)), m_stages[stage]);
+    const LatencyHistogram &present = m_stages[StagePresent];
+    appendHistogram(stream, L"key to pinned activation", m_pinned_activation);
+    appendHistogram(stream, L"config reload", m_config_reload);
+    stream << L"hook reinstalls: " << m_hook_reinstalls
+            << L" failed=" << m_failed_hook_reinstalls << L"\n";
+    stream << L"budget " << kLatencyBudget << L"us: "
+            << (present.percentile(99) <= kLatencyBudget ? L"met" : L"exceeded") << L" at p99\n";
+
+    appendHistogram(stream, L"first paint", m_first_paint);
+    appendHistogram(stream, L"input latency", m_input_latency);
+    appendHistogram(stream, L"frame time", m_frame_time);
+    appendHistogram(stream, L"live thumbnails", m_live_thumbnails, L"");
+    stream << L"placeholder frames: " << m_placeholder_frames << L"\n";
+    appendHistogram(stream, L"rehydration", m_rehydration);
+    stream << L"working set: " << currentWorkingSet() / 1024 << L"KB\n";
+    for (int tier = 0; tier < kTrimTierCount; ++tier) {
+        stream << L"trim tier " << tier + 1 << L": n=" << m_trims[tier].count
+                << L" last=" << m_trims[tier].before / 1024 << L"KB->"
+                << m_trims[tier].after / 1024 << L"KB\n";
+    }
+    return stream.str();
+}
+
+std::wstring Metrics::latencySummary() const
+{
+    std::wostringstream stream;
+    if (m_hook_time) {
+        stream << L"hook time p99=" << m_hook_time->percentile(99)
+                << L"us max=" << m_hook_time->maxValue() << L"us, ";
+    }
+    const LatencyHistogram &present = m_stages[StagePresent];
+    stream << L"key to present p99=" << present.percentile(99)
+            << L"us max=" << present.maxValue() << L"us";
+    return stream.str();
+}
+
+bool Metrics::exportReport(const std::wstring &file_path) const
+{
+    std::wofstream file(file_path, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+    file << report();
+    return file.good();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "utils/LatencyHistogram.h"
+
+#include <Windows.h>
+
+#include <atomic>
+#include <string>
+
+// microseconds from the performance counter
+uint64_t currentMicroseconds();
+// resident memory of the process in bytes
+size_t currentWorkingSet();
+
+// histograms are recorded from any thread, report() may run while they are recorded
+class Metrics
+{
+public:
+    // steps of a hotkey, each measured from the time its key event reached the hook
+    enum Stage
+    {
+        StageDispatch,  // drained by the main window
+        StageSnapshot,  // windows enumerated
+        StageLayout,  // layout of a view built
+        StageDraw,  // first drawing into the surface
+        StagePresent,  // first present, key to photon
+        StageNumber
+    };
+    static constexpr uint64_t kLatencyBudget = 16000;  // microseconds from key to photon
+
+    static Metrics *instance();
+
+    // show() to first present of a view
+    LatencyHistogram &firstPaint() { return m_first_paint; }
+    // hotkey posted by the message thread to the command start on the render thread
+    LatencyHistogram &inputLatency() { return m_input_latency; }
+    // render thread time spent in one frame
+    LatencyHistogram &frameTime() { return m_frame_time; }
+    // live DWM thumbnails of a view per presented frame
+    LatencyHistogram &liveThumbnails() { return m_live_thumbnails; }
+    // frames presented with placeholders while scrolling fast
+    uint64_t placeholderFrames() const { return m_placeholder_frames; }
+    void addPlaceholderFrame() { m_placeholder_frames.fetch_add(1, std::memory_order_relaxed); }
+    // show() to first present of a view whose resources were trimmed while idle
+    LatencyHistogram &rehydration() { return m_rehydration; }
+    // working set before and after the last trim of each tier
+    void recordTrim(int tier, size_t before, size_t after);
+
+    LatencyHistogram &stage(Stage stage) { return m_stages[stage]; }
+    // key to activation call of a pinned window, on the message thread
+    LatencyHistogram &pinnedActivation() { return m_pinned_activation; }
+    // changed ini file read on the message thread to its settings applied on the render thread
+    LatencyHistogram &configReload() { return m_config_reload; }
+    // time spent in the hook per key, histogram of the hook library
+    void setHookTime(const LatencyHistogram *histogram) { m_hook_time = histogram; }
+    // render thread only, later stages are recorded once against this key event
+    void beginKeyEvent(uint64_t key_time);
+    // stages of a key event that presents nothing more are not recorded against it
+    void endKeyEvent() { m_key_time = 0; }
+    void markStage(Stage stage);
+    // hook removed by Windows and installed again by the watchdog
+    void recordHookReinstall(bool success);
+
+    std::wstring report() const;
+    // one line of the hook and key to present latencies
+    std::wstring latencySummary() const;
+    // write report into file, replacing it
+    bool exportReport(const std::wstring &file_path) const;
+
+private:
+    Metrics() = default;
+    ~Metrics() = default;
+
+    LatencyHistogram m_first_paint;
+    LatencyHistogram m_input_latency;
+    LatencyHistogram m_frame_time;
+    LatencyHistogram m_live_thumbnails;
+    std::atomic<uint64_t> m_placeholder_frames = { 0 };
+    LatencyHistogram m_rehydration;
+
+    static constexpr int kTrimTierCount = 2;
+    struct TrimRecord
+    {
+        std::atomic<uint64_t> count = { 0 };
+        std::atomic<size_t> before = { 0 };
+        std::atomic<size_t> after = { 0 };
+    };
+    TrimRecord m_trims[kTrimTierCount];
+
+    LatencyHistogram m_stages[StageNumber];
+    LatencyHistogram m_pinned_activation;
+    LatencyHistogram m_config_reload;
+    const LatencyHistogram *m_hook_time = nullptr;
+    uint64_t m_key_time = 0;  // 0 when no key event is measured
+    unsigned m_marked_stages = 0;  // bits of stages recorded for the key event
+    std::atomic<uint64_t> m_hook_reinstalls = { 0 };
+    std::atomic<uint64_t> m_failed_hook_reinstalls = { 0 };
+};
+
+Metrics *metrics();
@@ -0,0 +1,72 @@
+#include "PinnedWindow.h"
+#include "WindowHandle.h"
+
+#include <array>
+
+static std::wstring lowerCase(std::wstring str)
+{
+    if (!str.empty())
+        CharLowerBuff(&str[0], static_cast<DWORD>(str.size()));
+    return str;
+}
+
+static std::wstring fromUtf8(const std::string &str)
+{
+    if (str.empty())
+        return {};
+    const int length = MultiByteToWideChar(CP_UTF8, 0, str.data(), static_cast<int>(str.size()),
+            nullptr, 0);
+    std::wstring result(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, str.data(), static_cast<int>(str.size()), &result[0], length);
+    return result;
+}
+
+PinnedWindow::PinnedWindow(const std::string &pattern)
+{
+    const size_t pos = pattern.find('|');
+    m_exe_name = lowerCase(fromUtf8(pattern.substr(0, pos)));
+    if (pos != std::string::npos)
+        m_title = lowerCase(fromUtf8(pattern.substr(pos + 1)));
+}
+
+HWND PinnedWindow::resolve()
+{
+    if (m_hwnd && IsWindow(m_hwnd))
+        return m_hwnd;
+
+    m_hwnd = nullptr;
+    if (!empty())
+        EnumWindows(enumWindowsProc, reinterpret_cast<LPARAM>(this));
+    return m_hwnd;
+}
+
+BOOL CALLBACK PinnedWindow::enumWindowsProc(HWND hwnd, LPARAM lParam)
+{
+    PinnedWindow *pinned = reinterpret_cast<PinnedWindow *>(lParam);
+    if (!pinned->matches(hwnd))
+        return TRUE;
+    pinned->m_hwnd = hwnd;
+    return FALSE;
+}
+
+bool PinnedWindow::matches(HWND hwnd) const
+{
+    // minimized windows are pinned too, unlike windows of views
+    if (!IsWindowVisible(hwnd) || GetWindowLongPtr(hwnd, GWL_EXSTYLE) & WS_EX_TOOLWINDOW)
+        return false;
+
+    // title first, exe path needs to open the process
+    std::array<wchar_t, 256> buffer;
+    if (GetWindowText(hwnd, buffer.data(), static_cast<int>(buffer.size())) == 0)
+        return false;
+    if (!m_title.empty() && lowerCase(buffer.data()).find(m_title) == std::wstring::npos)
+        return false;
+
+    if (!m_exe_name.empty()) {
+        const std::wstring exe_path = lowerCase(WindowHandle::exePathOf(hwnd));
+        const size_t pos = exe_path.find_last_of(L'\\');
+        if (exe_path.compare(pos == std::wstring::npos ? 0 : pos + 1, std::wstring::npos, m_exe_name) != 0)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <string>
+
+// window found by exe name and title, the handle is kept until the window is closed
+class PinnedWindow
+{
+public:
+    // pattern is "exe name|part of title" in UTF-8, either part may be empty
+    explicit PinnedWindow(const std::string &pattern);
+
+    bool empty() const { return m_exe_name.empty() && m_title.empty(); }
+    // cached window, searched again only when it was closed
+    HWND resolve();
+
+private:
+    static BOOL CALLBACK enumWindowsProc(HWND hwnd, LPARAM lParam);
+
+    bool matches(HWND hwnd) const;
+
+    std::wstring m_exe_name;  // lower case
+    std::wstring m_title;  // lower case
+    HWND m_hwnd = nullptr;
+};
@@ -0,0 +1,87 @@
+#include "RenderThread.h"
+#include "GlobalData.h"
+#include "Metrics.h"
+#include "resource.h"
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+bool RenderThread::start(HINSTANCE instance)
+{
+    if (m_thread.joinable())
+        return true;
+
+    std::promise<bool> started;
+    std::future<bool> result = started.get_future();
+    m_thread = std::thread(&RenderThread::run, this, instance, &started);
+    if (result.get())
+        return true;
+
+    m_thread.join();
+    return false;
+}
+
+void RenderThread::stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    PostThreadMessage(m_thread_id, WM_QUIT, 0, 0);
+    m_thread.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_commands.clear();
+}
+
+void RenderThread::post(Command command)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        wake = m_commands.empty();
+        m_commands.emplace_back(currentMicroseconds(), std::move(command));
+    }
+
+    // one message wakes the thread for a batch of commands
+    if (wake)
+        PostThreadMessage(m_thread_id, WMAPP_RENDER, 0, 0);
+}
+
+void RenderThread::run(HINSTANCE instance, std::promise<bool> *started)
+{
+    // create message queue before any command can be posted
+    MSG msg;
+    PeekMessage(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    m_thread_id = GetCurrentThreadId();
+
+    const bool success = globalData()->initializeViews(instance);
+    started->set_value(success);
+
+    while (success && GetMessage(&msg, nullptr, 0, 0) > 0) {
+        if (!msg.hwnd && msg.message == WMAPP_RENDER) {
+            runCommands();
+            continue;
+        }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    // windows must be destroyed by the thread that created them
+    globalData()->destroyViews();
+}
+
+void RenderThread::runCommands()
+{
+    std::deque<std::pair<uint64_t, Command>> commands;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        commands.swap(m_commands);
+    }
+
+    for (auto &command : commands) {
+        metrics()->inputLatency().record(currentMicroseconds() - command.first);
+        command.second();
+    }
+}
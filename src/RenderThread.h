@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// thread that owns the thumbnail views. enumeration, layout, drawing and DWM calls
+// run here, so a slow frame never delays the message thread serving the keyboard hook
+class RenderThread
+{
+public:
+    using Command = std::function<void()>;
+
+    ~RenderThread();
+
+    // create views on the new thread and wait for the result
+    bool start(HINSTANCE instance);
+    void stop();
+
+    // run command on the render thread, commands run in the order they are posted
+    void post(Command command);
+
+private:
+    void run(HINSTANCE instance, std::promise<bool> *started);
+    void runCommands();
+
+    std::thread m_thread;
+    DWORD m_thread_id = 0;
+
+    std::mutex m_mutex;
+    std::deque<std::pair<uint64_t, Command>> m_commands;  // with post time
+};
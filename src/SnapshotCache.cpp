@@ -0,0 +1,246 @@
+#include "SnapshotCache.h"
+#include "Configure.h"
+#include "GlobalData.h"
+#include "RenderThread.h"
+
+#include <Shlwapi.h>
+
+#pragma comment(lib, "shlwapi.lib")
+
+#ifndef PW_RENDERFULLCONTENT
+#define PW_RENDERFULLCONTENT 0x00000002
+#endif
+
+static bool findEncoder(const wchar_t *mime_type, CLSID *clsid)
+{
+    UINT count = 0, size = 0;
+    if (Gdiplus::GetImageEncodersSize(&count, &size) != Gdiplus::Ok || size == 0)
+        return false;
+
+    std::vector<BYTE> buffer(size);
+    Gdiplus::ImageCodecInfo *encoders = reinterpret_cast<Gdiplus::ImageCodecInfo *>(buffer.data());
+    if (Gdiplus::GetImageEncoders(count, size, encoders) != Gdiplus::Ok)
+        return false;
+
+    for (UINT i = 0; i < count; ++i) {
+        if (wcscmp(encoders[i].MimeType, mime_type) == 0) {
+            *clsid = encoders[i].Clsid;
+            return true;
+        }
+    }
+    return false;
+}
+
+SnapshotCache::~SnapshotCache()
+{
+    m_hook.reset();
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool SnapshotCache::initialize()
+{
+    if (m_hook)
+        return true;
+
+    m_hook = {
+        SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                winEventProc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS),
+        UnhookWinEvent
+    };
+    if (!m_hook)
+        return false;
+
+    m_foreground = GetForegroundWindow();
+    m_thread = std::thread(&SnapshotCache::run, this);
+    return true;
+}
+
+std::unique_ptr<Gdiplus::Bitmap> SnapshotCache::load(HWND hwnd)
+{
+    const std::vector<BYTE> *data = m_snapshots.get(hwnd);
+    if (!data || data->empty())
+        return nullptr;
+
+    std::unique_ptr<IStream, void (*)(IStream *)> stream = {
+        SHCreateMemStream(data->data(), static_cast<UINT>(data->size())),
+        [](IStream *stream) { stream->Release(); }
+    };
+    if (!stream)
+        return nullptr;
+
+    // decoded bitmap reads the stream lazily, copy it to an independent bitmap
+    Gdiplus::Bitmap decoded(stream.get());
+    if (decoded.GetLastStatus() != Gdiplus::Ok)
+        return nullptr;
+    auto bitmap = std::make_unique<Gdiplus::Bitmap>(decoded.GetWidth(), decoded.GetHeight(),
+            PixelFormat32bppPARGB);
+    Gdiplus::Graphics graphics(bitmap.get());
+    graphics.DrawImage(&decoded, 0, 0, decoded.GetWidth(), decoded.GetHeight());
+    return bitmap;
+}
+
+void SnapshotCache::capture(HWND hwnd)
+{
+    // minimized again before the last capture finished
+    if (!m_pending.insert(hwnd).second)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(hwnd);
+    }
+    m_wake.notify_one();
+}
+
+void SnapshotCache::run()
+{
+    while (true) {
+        HWND hwnd = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+            if (m_stop)
+                return;
+            hwnd = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        // an empty result still clears the pending capture
+        std::vector<BYTE> data = captureImage(hwnd);
+        globalData()->renderThread()->post([hwnd, data]() {
+            SnapshotCache *cache = globalData()->snapshotCache();
+            if (cache)
+                cache->store(hwnd, data);
+        });
+    }
+}
+
+void SnapshotCache::store(HWND hwnd, std::vector<BYTE> data)
+{
+    m_pending.erase(hwnd);
+    // a failed capture keeps the last snapshot
+    if (!data.empty())
+        m_snapshots.put(hwnd, std::move(data));
+}
+
+std::vector<BYTE> SnapshotCache::captureImage(HWND hwnd)
+{
+    // PrintWindow would wait for a window that does not respond
+    if (!IsWindow(hwnd) || IsHungAppWindow(hwnd))
+        return {};
+
+    // PrintWindow draws the whole window rect, crop invisible borders outside the frame
+    WINDOWPLACEMENT placement = { sizeof(placement) };
+    RECT window_rect, frame_rect;
+    if (!GetWindowPlacement(hwnd, &placement) || !GetWindowRect(hwnd, &window_rect)
+            || FAILED(DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS,
+                    &frame_rect, sizeof(frame_rect))))
+        return {};
+    // a minimized window prints only its caption, the snapshot would be blank
+    if (IsIconic(hwnd) || placement.showCmd == SW_SHOWMINIMIZED)
+        return {};
+    const int width = window_rect.right - window_rect.left;
+    const int height = window_rect.bottom - window_rect.top;
+    if (placement.showCmd != SW_SHOWMAXIMIZED) {
+        // the window rect differs from the restored size while it is being minimized
+        const RECT &normal_rect = placement.rcNormalPosition;
+        if (width != normal_rect.right - normal_rect.left
+                || height != normal_rect.bottom - normal_rect.top)
+            return {};
+    }
+    const int frame_width = frame_rect.right - frame_rect.left;
+    const int frame_height = frame_rect.bottom - frame_rect.top;
+    if (width <= 0 || height <= 0 || frame_width <= 0 || frame_height <= 0)
+        return {};
+
+    auto release_dc = [](HDC hdc) { ReleaseDC(nullptr, hdc); };
+    std::unique_ptr<HDC__, decltype(release_dc)> screen_dc = { GetDC(nullptr), release_dc };
+    std::unique_ptr<HDC__, decltype(&DeleteDC)> dc = { CreateCompatibleDC(screen_dc.get()), DeleteDC };
+    std::unique_ptr<HBITMAP__, decltype(&DeleteObject)> bitmap = {
+        CreateCompatibleBitmap(screen_dc.get(), width, height), DeleteObject
+    };
+    if (!dc || !bitmap)
+        return {};
+    HGDIOBJ old_bitmap = SelectObject(dc.get(), bitmap.get());
+    const bool printed = PrintWindow(hwnd, dc.get(), PW_RENDERFULLCONTENT);
+    SelectObject(dc.get(), old_bitmap);
+    // minimized while it was printed
+    if (!printed || IsIconic(hwnd))
+        return {};
+
+    // downscale
+    Gdiplus::Bitmap full(bitmap.get(), nullptr);
+    const float scale = frame_width > kMaxWidth ? static_cast<float>(kMaxWidth) / frame_width : 1.f;
+    const int scaled_width = max(static_cast<int>(frame_width * scale), 1);
+    const int scaled_height = max(static_cast<int>(frame_height * scale), 1);
+    Gdiplus::Bitmap scaled(scaled_width, scaled_height, PixelFormat24bppRGB);
+    {
+        Gdiplus::Graphics graphics(&scaled);
+        graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBilinear);
+        graphics.DrawImage(&full, Gdiplus::Rect(0, 0, scaled_width, scaled_height),
+                frame_rect.left - window_rect.left, frame_rect.top - window_rect.top,
+                frame_width, frame_height, Gdiplus::UnitPixel);
+    }
+
+    // compress
+    static CLSID png_clsid;
+    static const bool has_png = findEncoder(L"image/png", &png_clsid);
+    if (!has_png)
+        return {};
+
+    IStream *raw_stream = nullptr;
+    if (FAILED(CreateStreamOnHGlobal(nullptr, TRUE, &raw_stream)))
+        return {};
+    std::unique_ptr<IStream, void (*)(IStream *)> stream = {
+        raw_stream, [](IStream *stream) { stream->Release(); }
+    };
+    if (scaled.Save(stream.get(), &png_clsid, nullptr) != Gdiplus::Ok)
+        return {};
+
+    HGLOBAL global = nullptr;
+    STATSTG stat = {};
+    if (FAILED(GetHGlobalFromStream(stream.get(), &global))
+            || FAILED(stream->Stat(&stat, STATFLAG_NONAME)))
+        return {};
+    const BYTE *bits = static_cast<const BYTE *>(GlobalLock(global));
+    if (!bits)
+        return {};
+    std::vector<BYTE> data(bits, bits + static_cast<size_t>(stat.cbSize.QuadPart));
+    GlobalUnlock(global);
+    return data;
+}
+
+void SnapshotCache::prune()
+{
+    std::vector<HWND> stale;
+    m_snapshots.forEach([&stale](HWND hwnd, const std::vector<BYTE> &) {
+        if (!IsWindow(hwnd))
+            stale.push_back(hwnd);
+    });
+    for (HWND hwnd : stale)
+        m_snapshots.erase(hwnd);
+}
+
+void CALLBACK SnapshotCache::winEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+        LONG id_object, LONG id_child, DWORD event_thread, DWORD event_time)
+{
+    SnapshotCache *cache = globalData()->snapshotCache();
+    if (!cache || !hwnd || id_object != OBJID_WINDOW || id_child != CHILDID_SELF)
+        return;
+
+    // the window losing the foreground is still restored, its image is drawn once it is
+    // minimized. minimized windows are not shown at all if they are ignored
+    HWND previous = cache->m_foreground;
+    cache->m_foreground = hwnd;
+    if (previous && previous != hwnd && !config()->ignoreMinimized()
+            && IsWindow(previous) && !IsIconic(previous) && GetAncestor(previous, GA_ROOT) == previous)
+        cache->capture(previous);
+}
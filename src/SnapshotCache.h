@@ -0,0 +1,68 @@
+#pragma once
+
+#include "utils/LruCache.h"
+
+#include <Windows.h>
+#include <gdiplus.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// downscaled images of windows, drawn for them once they are minimized. live thumbnails
+// of minimized windows are blank, views draw the image instead of registering one.
+// a minimized window no longer paints its content, so windows are captured while still
+// restored, when they lose the foreground. PrintWindow waits for the window's thread,
+// captures run on a worker thread so a slow app never stalls frames, the images are
+// stored on the render thread
+class SnapshotCache
+{
+public:
+    static constexpr size_t kCapacity = 64;
+    static constexpr int kMaxWidth = 480;  // pixels
+
+    SnapshotCache() : m_snapshots(kCapacity) {}
+    ~SnapshotCache();
+
+    // install event hook and start the worker, events arrive on the calling thread
+    bool initialize();
+
+    size_t size() const { return m_snapshots.size(); }
+    bool contains(HWND hwnd) const { return m_snapshots.contains(hwnd); }
+    // decoded image, nullptr if not captured
+    std::unique_ptr<Gdiplus::Bitmap> load(HWND hwnd);
+
+    // queue a capture for the worker
+    void capture(HWND hwnd);
+    // drop snapshots of closed windows
+    void prune();
+
+private:
+    static void CALLBACK winEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+            LONG id_object, LONG id_child, DWORD event_thread, DWORD event_time);
+    // PNG compressed image of the restored window, empty on failure or if the window is
+    // minimized before it is printed. on the worker thread
+    static std::vector<BYTE> captureImage(HWND hwnd);
+
+    void run();
+    // result of the worker, on the render thread
+    void store(HWND hwnd, std::vector<BYTE> data);
+
+    std::unique_ptr<HWINEVENTHOOK__, decltype(&UnhookWinEvent)> m_hook = { nullptr, UnhookWinEvent };
+    // PNG compressed images
+    LruCache<HWND, std::vector<BYTE>> m_snapshots;
+    // queued or being captured, a window is captured once at a time
+    std::unordered_set<HWND> m_pending;
+    // loses the foreground with the next foreground event
+    HWND m_foreground = nullptr;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<HWND> m_queue;  // guarded by m_mutex
+    bool m_stop = false;  // guarded by m_mutex
+};
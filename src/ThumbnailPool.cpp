@@ -0,0 +1,146 @@
+#include "ThumbnailPool.h"
+
+ThumbnailPool::~ThumbnailPool()
+{
+    releaseAll();
+}
+
+HTHUMBNAIL ThumbnailPool::acquire(HWND src_hwnd, HWND dst_hwnd, bool *created)
+{
+    if (created)
+        *created = false;
+
+    const Key key(src_hwnd, dst_hwnd);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        // mark as most recently used
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru_it);
+        return it->second.thumbnail;
+    }
+
+    HTHUMBNAIL thumbnail = nullptr;
+    if (DwmRegisterThumbnail(dst_hwnd, src_hwnd, &thumbnail) != S_OK)
+        return nullptr;
+
+    m_lru.push_front(key);
+    m_entries.emplace(key, Entry{ thumbnail, m_lru.begin(), false });
+    if (created)
+        *created = true;
+
+    // thumbnails shown by views are not touched by every frame, so they may be anywhere
+    // in the list
+    enforceBudget(&key);
+
+    return thumbnail;
+}
+
+HTHUMBNAIL ThumbnailPool::find(HWND src_hwnd, HWND dst_hwnd) const
+{
+    auto it = m_entries.find(Key(src_hwnd, dst_hwnd));
+    return it != m_entries.end() ? it->second.thumbnail : nullptr;
+}
+
+void ThumbnailPool::show(HWND src_hwnd, HWND dst_hwnd, const RECT &dst_rect)
+{
+    m_pending.push_back({ Key(src_hwnd, dst_hwnd), true, dst_rect });
+}
+
+void ThumbnailPool::hide(HWND src_hwnd, HWND dst_hwnd)
+{
+    m_pending.push_back({ Key(src_hwnd, dst_hwnd), false, {} });
+}
+
+size_t ThumbnailPool::flush()
+{
+    size_t calls = 0;
+    for (const PendingUpdate &update : m_pending) {
+        DWM_THUMBNAIL_PROPERTIES props = {};
+        HTHUMBNAIL thumbnail = nullptr;
+        if (update.visible) {
+            bool created = false;
+            thumbnail = acquire(update.key.first, update.key.second, &created);
+            if (!thumbnail)
+                continue;
+            if (created) {
+                props.dwFlags |= DWM_TNP_SOURCECLIENTAREAONLY;
+                props.fSourceClientAreaOnly = FALSE;
+            }
+            props.dwFlags |= DWM_TNP_RECTDESTINATION | DWM_TNP_VISIBLE;
+            props.rcDestination = update.rect;
+            props.fVisible = TRUE;
+            m_entries.find(update.key)->second.visible = true;
+        } else {
+            // never registered, nothing to hide
+            auto it = m_entries.find(update.key);
+            if (it == m_entries.end())
+                continue;
+            thumbnail = it->second.thumbnail;
+            it->second.visible = false;
+            props.dwFlags = DWM_TNP_VISIBLE;
+            props.fVisible = FALSE;
+        }
+        DwmUpdateThumbnailProperties(thumbnail, &props);
+        ++calls;
+    }
+    m_pending.clear();
+
+    m_stats.last_flush_calls = calls;
+    m_stats.total_calls += calls;
+    ++m_stats.flushes;
+    return calls;
+}
+
+void ThumbnailPool::release(HWND src_hwnd, HWND dst_hwnd)
+{
+    auto it = m_entries.find(Key(src_hwnd, dst_hwnd));
+    if (it != m_entries.end())
+        evict(it);
+}
+
+void ThumbnailPool::releaseAll()
+{
+    for (auto &pair : m_entries)
+        DwmUnregisterThumbnail(pair.second.thumbnail);
+    m_entries.clear();
+    m_lru.clear();
+}
+
+void ThumbnailPool::prune()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (!IsWindow(it->first.first) || !IsWindow(it->first.second)) {
+            auto next = std::next(it);
+            evict(it);
+            it = next;
+        } else {
+            ++it;
+        }
+    }
+
+    enforceBudget(nullptr);
+}
+
+void ThumbnailPool::evict(std::unordered_map<Key, Entry>::iterator it)
+{
+    if (it == m_entries.end())
+        return;
+
+    DwmUnregisterThumbnail(it->second.thumbnail);
+    m_lru.erase(it->second.lru_it);
+    m_entries.erase(it);
+}
+
+void ThumbnailPool::enforceBudget(const Key *keep)
+{
+    auto it = m_lru.end();
+    while (m_entries.size() > m_budget && it != m_lru.begin()) {
+        --it;
+        auto entry = m_entries.find(*it);
+        if (entry->second.visible || (keep && *it == *keep))
+            continue;
+        // erased from the list, continue from the next more recent key
+        auto next = std::next(it);
+        evict(entry);
+        it = next;
+    }
+}
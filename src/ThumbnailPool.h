@@ -0,0 +1,73 @@
+#pragma once
+
+#include "utils/PairHash.h"
+
+#include <dwmapi.h>
+#include <Windows.h>
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// DWM thumbnail registrations keyed by (source, destination) window,
+// kept alive across snapshots so reopening the views does not register again
+class ThumbnailPool
+{
+public:
+    static constexpr size_t kDefaultBudget = 128;
+
+    struct Stats
+    {
+        size_t last_flush_calls = 0;  // DwmUpdateThumbnailProperties calls of the last frame
+        size_t total_calls = 0;
+        size_t flushes = 0;
+    };
+
+    explicit ThumbnailPool(size_t budget = kDefaultBudget) : m_budget(budget) {}
+    ~ThumbnailPool();
+
+    size_t size() const { return m_entries.size(); }
+    size_t budget() const { return m_budget; }
+    const Stats &stats() const { return m_stats; }
+
+    // return registered thumbnail, register it if absent, created is set if registered now
+    HTHUMBNAIL acquire(HWND src_hwnd, HWND dst_hwnd, bool *created = nullptr);
+    HTHUMBNAIL find(HWND src_hwnd, HWND dst_hwnd) const;
+
+    // queue property updates, they are sent together by flush() once per frame
+    void show(HWND src_hwnd, HWND dst_hwnd, const RECT &dst_rect);
+    void hide(HWND src_hwnd, HWND dst_hwnd);
+    size_t flush();
+
+    void release(HWND src_hwnd, HWND dst_hwnd);
+    void releaseAll();
+    // release registrations of destroyed windows and the least recently used over budget
+    void prune();
+
+private:
+    using Key = std::pair<HWND, HWND>;
+    struct Entry
+    {
+        HTHUMBNAIL thumbnail;
+        std::list<Key>::iterator lru_it;
+        bool visible;  // shown by a view and not hidden since, never evicted
+    };
+    struct PendingUpdate
+    {
+        Key key;
+        bool visible;
+        RECT rect;
+    };
+
+    void evict(std::unordered_map<Key, Entry>::iterator it);
+    // evict hidden registrations from the least recently used end, besides keep. the pool
+    // stays over budget while views show more thumbnails than it
+    void enforceBudget(const Key *keep);
+
+    size_t m_budget;
+    std::list<Key> m_lru;  // front is the most recently used
+    std::unordered_map<Key, Entry> m_entries;
+    std::vector<PendingUpdate> m_pending;
+    Stats m_stats;
+};
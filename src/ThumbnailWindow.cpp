@@ -1,20 +1,48 @@
 #include "ThumbnailWindow.h"
 #include "Configure.h"
+#include "FrameScheduler.h"
 #include "GlobalData.h"
 #include "KeyboardHook.h"
 #include "LayoutManager.h"
 #include "LayoutItem.h"
+#include "Metrics.h"
 #include "resource.h"
+#include "ThumbnailPool.h"
 #include "UIParam.h"
 
 #include <windowsx.h>
 
+#include <algorithm>
+#include <cmath>
+
 static bool multipleWindowsInGroup(const WindowGroup &group)
 {
     const std::vector<WindowHandle *> &windows = globalData()->windowsFromGroup(group);
     return windows.size() > 1;
 }
 
+static DamageRect toDamageRect(const RectF &rect)
+{
+    return {
+        static_cast<int>(std::floor(rect.X)), static_cast<int>(std::floor(rect.Y)),
+        static_cast<int>(std::ceil(rect.GetRight())), static_cast<int>(std::ceil(rect.GetBottom()))
+    };
+}
+
+static RectF toRectF(const DamageRect &rect)
+{
+    return RectF(rect.left, rect.top, rect.width(), rect.height());
+}
+
+// nearest pixel edges, as GDI+ fills without antialiasing
+static DamageRect toPixelRect(const RectF &rect)
+{
+    return {
+        static_cast<int>(std::lround(rect.X)), static_cast<int>(std::lround(rect.Y)),
+        static_cast<int>(std::lround(rect.GetRight())), static_cast<int>(std::lround(rect.GetBottom()))
+    };
+}
+
 ThumbnailWindowBase::~ThumbnailWindowBase()
 {
     hide();
@@ -33,6 +61,7 @@ LRESULT ThumbnailWindowBase::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
             m_fore_hwnd.reset();
         }
         m_visible = false;
+        m_cloaked = false;
         return 0;
 
     case WM_ERASEBKGND:
@@ -47,7 +76,7 @@ LRESULT ThumbnailWindowBase::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
         {
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hwnd, &ps);
-            handlePaint(hwnd, hdc);
+            handlePaint(hwnd, hdc, ps.rcPaint);
             EndPaint(hwnd, &ps);
         }
         return 0;
@@ -65,6 +94,13 @@ LRESULT ThumbnailWindowBase::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
         handleModUp(wParam);
         return 0;
 
+    case WM_TIMER:
+        if (hwnd == m_hwnd.get() && wParam == TimerIDSettle) {
+            handleScrollSettled();
+            return 0;
+        }
+        break;
+
     default:
         break;
     }
@@ -73,9 +109,25 @@ LRESULT ThumbnailWindowBase::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
 
 bool ThumbnailWindowBase::create(HINSTANCE instance)
 {
-    if (m_hwnd && m_fore_hwnd)
+    if (created())
         return true;
 
+    m_layered_surface = config()->singleLayeredWindow();
+    if (m_layered_surface) {
+        // content is presented by UpdateLayeredWindow, no border and no foreground window
+        m_hwnd = {
+            CreateWindowEx(
+                WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_LAYERED,
+                L"GroupTabBox", L"ThumbnailWindow",
+                WS_POPUP,
+                0, 0, 1, 1,
+                nullptr, nullptr, instance, nullptr
+            ),
+            DestroyWindow
+        };
+        return m_hwnd.get();
+    }
+
     m_hwnd = {
         CreateWindowEx(
             WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_LAYERED,
@@ -115,47 +167,230 @@ void ThumbnailWindowBase::show(bool keep)
     if (visible())
         return;
 
-    if ((!m_hwnd || !m_fore_hwnd) && !create(globalData()->hInstance()))
+    if (!created() && !create(globalData()->hInstance()))
         return;
 
     if (!keep && !globalData()->keyboardHook()->modUpNotifyOnce(m_hwnd.get(), MOD_ALT))
         return;
 
+    m_show_time = currentMicroseconds();
     m_keep_showing = keep;
+
+    if (current()) {
+        // surface is already rendered, start from the first item again
+        m_visible = true;
+        updateView({ 0, 0, m_rect.Width, m_rect.Height });
+        setSelected(m_layout_manager->itemAt(0));
+        m_present_damage.makeInfinite();
+        renderFrame();
+        setCloaked(false);
+    } else {
+        if (!render())
+            return;
+        placeWindows();
+        m_visible = true;
+        if (m_cloaked) {
+            // windows were shown already, nothing repaints them
+            m_present_damage.makeInfinite();
+            requestRepaint(true);
+            setCloaked(false);
+        }
+    }
+    scheduleDetails();
+
+    // alt may be released before the hotkey command reached the render thread
+    if (!keep && !(GetAsyncKeyState(VK_MENU) & 0x8000))
+        PostMessage(m_hwnd.get(), WMAPP_MODUP, MOD_ALT, 0);
+}
+
+void ThumbnailWindowBase::hide()
+{
+    if (!created() || !visible())
+        return;
+
+    globalData()->frameScheduler()->cancel(this);
+    KillTimer(m_hwnd.get(), TimerIDSettle);
+    m_fast_scrolling = false;
+
+    if (config()->cloakHiddenViews()) {
+        // keep windows, surface and thumbnails for the next show
+        setCloaked(true);
+        m_visible = false;
+        return;
+    }
+
+    if (!m_layered_surface && m_pixels.valid()) {
+        // clear foreground so the next show does not flash old content
+        PixelCompositor::fill(m_pixels, 0, 0, m_pixels.width, m_pixels.height,
+                PixelCompositor::premultiply(clearColor()));
+        m_drawn_top = m_drawn_bottom = 0;
+        m_present_damage.makeInfinite();
+        requestRepaint(true);
+    }
+
+    updateView({});
+    ShowWindow(m_hwnd.get(), SW_HIDE);
+    if (m_fore_hwnd)
+        ShowWindow(m_fore_hwnd.get(), SW_HIDE);
+    m_visible = false;
+}
+
+void ThumbnailWindowBase::prerender()
+{
+    if (!config()->cloakHiddenViews() || visible())
+        return;
+
+    if (!created() && !create(globalData()->hInstance()))
+        return;
+
+    if (current())
+        return;
+
+    // not measured, the next show only uncloaks
+    m_rehydrating = false;
+    setCloaked(true);
+    if (!render())
+        return;
+    placeWindows();
+    if (!m_thumbnail_updated)
+        updateThumbnails();
+    scheduleDetails();
+}
+
+void ThumbnailWindowBase::trim()
+{
+    if (!created() || visible())
+        return;
+
+    globalData()->frameScheduler()->cancel(this);
+    // nothing is left to uncloak, hide windows before the surface goes
+    hideCloaked();
+
+    // the surface can not be released while selected into the DC
+    m_surface.reset();
+    m_dc.reset();
+    m_bitmap.reset();
+    m_pixels = PixelSurface();
+    m_bitmap_size = { 0, 0 };
+    m_drawn_top = m_drawn_bottom = 0;
+    m_damage.clear();
+    m_present_damage.clear();
+    m_presented_selected = nullptr;
+
+    // layout is kept, details are loaded again after the first frame
+    if (m_layout_manager) {
+        for (size_t i = 0; const LayoutItem *item = m_layout_manager->itemAt(i); ++i)
+            item->unloadDetails();
+    }
+    m_rehydrating = true;
+}
+
+void ThumbnailWindowBase::releaseLayout()
+{
+    if (!created() || visible())
+        return;
+
+    // tasks and frames of a hidden view hold items of the layout
+    globalData()->frameScheduler()->cancel(this);
+    // cloaked windows present the old layout
+    hideCloaked();
+    m_layout_manager.reset();
+    m_selected = nullptr;
+    m_presented_selected = nullptr;
+    m_damage.clear();
+    m_present_damage.makeInfinite();
+}
+
+void ThumbnailWindowBase::refreshSettings(unsigned int changes)
+{
+    if (!created())
+        return;
+
+    if (changes & Configure::ChangeAlpha) {
+        if (m_layered_surface) {
+            // alpha is in the pixels of the surface
+            invalidate();
+        } else {
+            const float alpha = config()->backgroundAlpha();
+            SetLayeredWindowAttributes(m_hwnd.get(), 0, alpha * 255, LWA_ALPHA);
+        }
+    }
+    if (changes & Configure::ChangeViewContent)
+        invalidate();
+
+    if ((changes & Configure::ChangeCloak) && !config()->cloakHiddenViews() && !visible()) {
+        // hidden views are no longer uncloaked by the next show
+        globalData()->frameScheduler()->cancel(this);
+        hideCloaked();
+    }
+}
+
+void ThumbnailWindowBase::hideCloaked()
+{
+    if (!m_cloaked)
+        return;
+
+    updateView({});
+    ShowWindow(m_hwnd.get(), SW_HIDE);
+    if (m_fore_hwnd)
+        ShowWindow(m_fore_hwnd.get(), SW_HIDE);
+    setCloaked(false);
+}
+
+bool ThumbnailWindowBase::current() const
+{
+    return m_cloaked && !m_stale && m_layout_manager && m_layout_manager->itemAt(0)
+            && m_monitor == globalData()->currentMonitor()
+            && m_snapshot_version == globalData()->snapshotVersion();
+}
+
+bool ThumbnailWindowBase::render()
+{
+    // work of a previous layout refers to old items
+    globalData()->frameScheduler()->cancel(this);
+
     m_monitor = globalData()->currentMonitor();
+    m_snapshot_version = globalData()->snapshotVersion();
+    m_stale = false;
     initializeLayout();
+    metrics()->markStage(Metrics::StageLayout);
 
     // item at 0 is null means empty
     if (!m_layout_manager->itemAt(0))
-        return;
+        return false;
 
     initializeBitmap();
     updateBitmap(true);
     updateView({ 0, 0, m_rect.Width, m_rect.Height });
+    return true;
+}
 
-    // consider border
-    SetWindowPos(m_hwnd.get(), nullptr, m_rect.X - 1, m_rect.Y - 1,
-            m_rect.Width + 2, m_rect.Height + 2, SWP_SHOWWINDOW);
-    SetWindowPos(m_fore_hwnd.get(), nullptr, m_rect.X - 1, m_rect.Y - 1,
-            m_rect.Width + 2, m_rect.Height + 2, SWP_SHOWWINDOW);
-
-    m_visible = true;
+void ThumbnailWindowBase::placeWindows()
+{
+    if (m_layered_surface) {
+        // present before showing, so the first frame is complete
+        presentLayeredSurface();
+        SetWindowPos(m_hwnd.get(), nullptr, m_rect.X, m_rect.Y,
+                m_rect.Width, m_rect.Height, SWP_SHOWWINDOW);
+    } else {
+        // consider border
+        SetWindowPos(m_hwnd.get(), nullptr, m_rect.X - 1, m_rect.Y - 1,
+                m_rect.Width + 2, m_rect.Height + 2, SWP_SHOWWINDOW);
+        SetWindowPos(m_fore_hwnd.get(), nullptr, m_rect.X - 1, m_rect.Y - 1,
+                m_rect.Width + 2, m_rect.Height + 2, SWP_SHOWWINDOW);
+    }
 }
 
-void ThumbnailWindowBase::hide()
+void ThumbnailWindowBase::setCloaked(bool cloaked)
 {
-    if (!m_hwnd || !m_fore_hwnd || !visible())
+    if (m_cloaked == cloaked)
         return;
 
-    SelectObject(m_dc.get(), m_bitmap.get());
-    Graphics graphics(m_dc.get());
-    graphics.Clear(0xFF00FF00);
-    requestRepaint(true);
-
-    updateView({});
-    ShowWindow(m_hwnd.get(), SW_HIDE);
-    ShowWindow(m_fore_hwnd.get(), SW_HIDE);
-    m_visible = false;
+    BOOL value = cloaked;
+    DwmSetWindowAttribute(m_hwnd.get(), DWMWA_CLOAK, &value, sizeof(value));
+    if (m_fore_hwnd)
+        DwmSetWindowAttribute(m_fore_hwnd.get(), DWMWA_CLOAK, &value, sizeof(value));
+    m_cloaked = cloaked;
 }
 
 void ThumbnailWindowBase::activateSelected()
@@ -177,27 +412,93 @@ void ThumbnailWindowBase::selectPrev()
     setSelected(m_layout_manager->getPrevItem(m_selected));
 }
 
+ARGB ThumbnailWindowBase::clearColor() const
+{
+    if (!m_layered_surface)
+        return 0xFF00FF00;  // color key of foreground window
+
+    // translucent background, premultiplied by GDI+ when written to the surface
+    const BYTE alpha = static_cast<BYTE>(config()->backgroundAlpha() * 255);
+    return (static_cast<ARGB>(alpha) << 24) | (globalData()->UI()->backgroundColor() & 0x00FFFFFF);
+}
+
 void ThumbnailWindowBase::requestRepaint(bool repaint_background)
 {
     if (!visible())
         return;
 
+    if (m_layered_surface) {
+        if (!m_present_damage.empty() || !m_thumbnail_updated)
+            presentLayeredSurface();
+        return;
+    }
+
     if (repaint_background) {
         InvalidateRect(m_hwnd.get(), nullptr, false);
         UpdateWindow(m_hwnd.get());
     }
-    InvalidateRect(m_fore_hwnd.get(), nullptr, false);
+
+    if (m_present_damage.empty())
+        return;
+
+    if (m_present_damage.infinite()) {
+        InvalidateRect(m_fore_hwnd.get(), nullptr, false);
+    } else {
+        // invalidate only damaged rects, converted to client coordinates
+        const DamageRect client_rect = {
+            0, 0, static_cast<int>(m_rect.Width), static_cast<int>(m_rect.Height)
+        };
+        for (DamageRect rect : m_present_damage) {
+            rect.offset(-static_cast<int>(m_view_rect.X), -static_cast<int>(m_view_rect.Y));
+            rect = rect.intersected(client_rect);
+            if (rect.empty())
+                continue;
+            RECT rc = { rect.left, rect.top, rect.right, rect.bottom };
+            InvalidateRect(m_fore_hwnd.get(), &rc, false);
+        }
+    }
+    m_present_damage.clear();
     UpdateWindow(m_fore_hwnd.get());
 }
 
-void ThumbnailWindowBase::initializeBitmap()
+void ThumbnailWindowBase::presentLayeredSurface()
 {
-    auto release_dc = [this](HDC hdc) { ReleaseDC(m_fore_hwnd.get(), hdc); };
-    std::unique_ptr<HDC__, decltype(release_dc)> hdc = { GetDC(m_fore_hwnd.get()), release_dc };
-
     if (!m_dc)
-        m_dc = { CreateCompatibleDC(hdc.get()), DeleteDC };
+        return;
 
+    if (!m_thumbnail_updated)
+        updateThumbnails();
+
+    POINT dst_pos = { static_cast<LONG>(m_rect.X), static_cast<LONG>(m_rect.Y) };
+    SIZE size = { static_cast<LONG>(m_rect.Width), static_cast<LONG>(m_rect.Height) };
+    POINT src_pos = { static_cast<LONG>(m_view_rect.X), static_cast<LONG>(m_view_rect.Y) };
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+
+    // update only the bounds of damage
+    RECT dirty_rect = { 0, 0, size.cx, size.cy };
+    if (!m_present_damage.infinite()) {
+        DamageRect rect = m_present_damage.bounds();
+        rect.offset(-src_pos.x, -src_pos.y);
+        rect = rect.intersected({ 0, 0, size.cx, size.cy });
+        dirty_rect = { rect.left, rect.top, rect.right, rect.bottom };
+    }
+
+    UPDATELAYEREDWINDOWINFO info = { sizeof(info) };
+    info.pptDst = &dst_pos;
+    info.psize = &size;
+    info.hdcSrc = m_dc.get();
+    info.pptSrc = &src_pos;
+    info.pblend = &blend;
+    info.dwFlags = ULW_ALPHA;
+    info.prcDirty = &dirty_rect;
+    UpdateLayeredWindowIndirect(m_hwnd.get(), &info);
+
+    m_present_damage.clear();
+    markPresented();
+}
+
+void ThumbnailWindowBase::initializeBitmap()
+{
     const RectF &layout_rect = m_layout_manager->rect();
     const SIZE bitmap_size = {
         max(static_cast<LONG>(layout_rect.Width), static_cast<LONG>(m_rect.Width)),
@@ -205,18 +506,48 @@ void ThumbnailWindowBase::initializeBitmap()
     };
 
     // redraw all next time
-    m_dirty_region.MakeInfinite();
+    m_damage.makeInfinite();
 
-    if (m_bitmap) {
-        SIZE current_size;
-        if (GetBitmapDimensionEx(m_bitmap.get(), &current_size)
-                && current_size.cx == bitmap_size.cx && current_size.cy == bitmap_size.cy)
-            return;
-    }
+    if (m_bitmap && m_bitmap_size.cx == bitmap_size.cx && m_bitmap_size.cy == bitmap_size.cy)
+        return;
+
+    // release old surface, the bitmap can not be deleted while selected into a DC
+    m_surface.reset();
+    m_dc.reset();
+    m_pixels = PixelSurface();
+    m_bitmap_size = { 0, 0 };
+
+    auto release_dc = [this](HDC hdc) { ReleaseDC(surfaceHwnd(), hdc); };
+    std::unique_ptr<HDC__, decltype(release_dc)> hdc = { GetDC(surfaceHwnd()), release_dc };
+
+    // top-down 32 bit DIB, shared by GDI presentation and GDI+ drawing
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = bitmap_size.cx;
+    info.bmiHeader.biHeight = -bitmap_size.cy;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+    void *bits = nullptr;
     m_bitmap = {
-        CreateCompatibleBitmap(hdc.get(), bitmap_size.cx, bitmap_size.cy),
+        CreateDIBSection(hdc.get(), &info, DIB_RGB_COLORS, &bits, nullptr, 0),
         DeleteObject
     };
+    if (!m_bitmap || !bits)
+        return;
+
+    m_dc = { CreateCompatibleDC(hdc.get()), DeleteDC };
+    if (!m_dc)
+        return;
+    SelectObject(m_dc.get(), m_bitmap.get());
+
+    m_surface = std::make_unique<Gdiplus::Bitmap>(bitmap_size.cx, bitmap_size.cy,
+            bitmap_size.cx * 4, PixelFormat32bppPARGB, static_cast<BYTE *>(bits));
+    m_pixels.pixels = static_cast<uint32_t *>(bits);
+    m_pixels.width = bitmap_size.cx;
+    m_pixels.height = bitmap_size.cy;
+    m_pixels.stride = bitmap_size.cx;
+    m_bitmap_size = bitmap_size;
 }
 
 void ThumbnailWindowBase::updateView(const RectF &next_view_rect)
@@ -225,45 +556,204 @@ void ThumbnailWindowBase::updateView(const RectF &next_view_rect)
         return;
 
     m_thumbnail_updated = false;
+    // view moved, present the whole window next time
+    m_present_damage.makeInfinite();
 
-    std::vector<const LayoutItem *> current_items = m_layout_manager->intersectItems(m_view_rect);
-    // hide all item if next is empty
     if (next_view_rect.IsEmptyArea()) {
-        for (const auto &item : current_items)
-            item->windowHandle()->hideThumbnail(m_fore_hwnd.get());
         m_view_rect = { 0, 0, 0, 0 };
+        // no paint follows an empty view, hide all thumbnails now
+        updateThumbnails();
+        return;
+    }
+
+    if (!m_view_rect.IsEmptyArea() && m_view_rect.Height == next_view_rect.Height)
+        trackScroll(next_view_rect.Y - m_view_rect.Y);
+    m_view_rect = next_view_rect;
+    exposeView();
+}
+
+void ThumbnailWindowBase::trackScroll(REAL distance)
+{
+    const float speed_limit = config()->placeholderScrollSpeed();
+    if (speed_limit <= 0 || distance == 0)
         return;
+
+    // speed since the last step, a single step after a pause is slow
+    const uint64_t now = currentMicroseconds();
+    const uint64_t elapsed = max(now - m_last_scroll_time, static_cast<uint64_t>(1000));
+    m_last_scroll_time = now;
+    const float speed = std::fabs(distance) * 1000000.f / elapsed;
+
+    if (speed >= speed_limit)
+        m_fast_scrolling = true;
+    if (m_fast_scrolling) {
+        // promote thumbnails once no step came within settle delay
+        SetTimer(m_hwnd.get(), TimerIDSettle,
+                max(static_cast<UINT>(config()->thumbnailSettleDelay()),
+                        static_cast<UINT>(USER_TIMER_MINIMUM)), nullptr);
     }
+}
+
+void ThumbnailWindowBase::handleScrollSettled()
+{
+    KillTimer(m_hwnd.get(), TimerIDSettle);
+    if (!m_fast_scrolling)
+        return;
+
+    m_fast_scrolling = false;
+    if (visible())
+        updateThumbnails();
+}
+
+void ThumbnailWindowBase::updateThumbnails()
+{
+    ThumbnailPool *pool = globalData()->thumbnailPool();
+    if (!pool)
+        return;
 
-    std::vector<const LayoutItem *> next_items = m_layout_manager->intersectItems(next_view_rect);
-    // hide invisible items
-    for (const auto &item : current_items) {
-        if (std::find(next_items.begin(), next_items.end(), item) == next_items.end()
-                || !next_view_rect.IntersectsWith(item->thumbnailRect()))
-            item->windowHandle()->hideThumbnail(m_fore_hwnd.get());
+    // live thumbnails in view and prefetch band, placeholders drawn under them show
+    // through while scrolling fast
+    std::vector<ThumbnailPlacement> next_placements;
+    if (m_layout_manager && !m_view_rect.IsEmptyArea() && !m_fast_scrolling) {
+        RectF live_rect = m_view_rect;
+        live_rect.Inflate(0, m_view_rect.Height * config()->thumbnailPrefetchBand());
+        for (const auto &item : m_layout_manager->intersectItems(live_rect)) {
+            if (!item->hasThumbnail() || !live_rect.IntersectsWith(item->thumbnailRect())
+                    || item->usesSnapshot())
+                continue;
+            RectF rect = item->thumbnailRect();
+            rect.Offset(-m_view_rect.X + border(), -m_view_rect.Y + border());
+            next_placements.push_back({
+                item->windowHandle()->hwnd(),
+                {
+                    static_cast<LONG>(std::ceil(rect.X)),
+                    static_cast<LONG>(std::ceil(rect.Y)),
+                    static_cast<LONG>(std::ceil(rect.GetRight())),
+                    static_cast<LONG>(std::ceil(rect.GetBottom()))
+                }
+            });
+        }
     }
+    auto less = [](const ThumbnailPlacement &a, const ThumbnailPlacement &b) {
+        return a.source < b.source;
+    };
+    std::sort(next_placements.begin(), next_placements.end(), less);
+
+    // merge sorted placements, only touch thumbnails that appeared, disappeared or moved
+    HWND dst_hwnd = surfaceHwnd();
+    auto current = m_placements.begin(), next = next_placements.begin();
+    while (current != m_placements.end() || next != next_placements.end()) {
+        if (next == next_placements.end()
+                || (current != m_placements.end() && less(*current, *next))) {
+            pool->hide(current->source, dst_hwnd);
+            ++current;
+        } else if (current == m_placements.end() || less(*next, *current)) {
+            pool->show(next->source, dst_hwnd, next->rect);
+            ++next;
+        } else {
+            if (!EqualRect(&current->rect, &next->rect))
+                pool->show(next->source, dst_hwnd, next->rect);
+            ++current;
+            ++next;
+        }
+    }
+    m_placements = std::move(next_placements);
 
-    m_view_rect = next_view_rect;
+    pool->flush();
+    m_thumbnail_updated = true;
+
+    if (m_fast_scrolling) {
+        metrics()->addPlaceholderFrame();
+    } else if (!m_view_rect.IsEmptyArea()) {
+        metrics()->liveThumbnails().record(m_placements.size());
+    }
 }
 
 void ThumbnailWindowBase::updateBitmap(bool redraw_all)
 {
-    if (!m_dc || !m_bitmap) {
+    if (!m_surface) {
         initializeBitmap();
         redraw_all = true;
     }
+    if (!m_surface)
+        return;
 
     if (redraw_all)
-        m_dirty_region.MakeInfinite();
+        m_damage.makeInfinite();
+
+    if (m_damage.infinite()) {
+        if (m_compact_layout) {
+            // draw the view now, other rows when they are scrolled into view
+            m_damage.clear();
+            m_drawn_top = m_drawn_bottom = 0;
+            exposeView();
+        } else {
+            // items of other layouts differ in size and group shadows reach past them,
+            // rows are not cut cleanly, so the whole bitmap is drawn as before
+            m_drawn_top = 0;
+            m_drawn_bottom = static_cast<REAL>(m_bitmap_size.cy);
+        }
+    }
 
-    SelectObject(m_dc.get(), m_bitmap.get());
-    Graphics graphics(m_dc.get());
-    if (m_dirty_region.IsEmpty(&graphics))
+    const DamageRect bitmap_rect = { 0, 0, m_bitmap_size.cx, m_bitmap_size.cy };
+    m_damage.clip(bitmap_rect.intersected(toDamageRect(
+            { 0, m_drawn_top, static_cast<REAL>(m_bitmap_size.cx), m_drawn_bottom - m_drawn_top })));
+    if (m_damage.empty())
         return;
 
+    Graphics graphics(m_surface.get());
     beforeDrawContent(&graphics);
     drawContent(&graphics);
+    m_present_damage.unite(m_damage);
     afterDrawContent(&graphics);
+    metrics()->markStage(Metrics::StageDraw);
+}
+
+void ThumbnailWindowBase::exposeView()
+{
+    // other layouts draw the whole bitmap
+    if (!m_compact_layout || !m_layout_manager || m_view_rect.IsEmptyArea())
+        return;
+
+    REAL top = m_view_rect.Y, bottom = m_view_rect.GetBottom();
+    if (m_drawn_bottom <= m_drawn_top || bottom < m_drawn_top || top > m_drawn_bottom) {
+        // far from the drawn rows, which are left as they are and drawn again when exposed
+        addRowDamage(&top, &bottom);
+        m_drawn_top = top;
+        m_drawn_bottom = bottom;
+        return;
+    }
+
+    if (top < m_drawn_top) {
+        REAL exposed_bottom = m_drawn_top;
+        addRowDamage(&top, &exposed_bottom);
+        m_drawn_top = top;
+    }
+    if (bottom > m_drawn_bottom) {
+        REAL exposed_top = m_drawn_bottom;
+        addRowDamage(&exposed_top, &bottom);
+        m_drawn_bottom = bottom;
+    }
+}
+
+void ThumbnailWindowBase::addRowDamage(REAL *top, REAL *bottom)
+{
+    // items are drawn whole, widen rows until no item is cut, including select frame
+    const UIParam *ui = globalData()->UI();
+    const REAL margin = ui->selectFrameMargin() + (ui->selectFrameWidth() / 2) + 1;
+    const REAL width = m_layout_manager->rect().Width;
+    while (true) {
+        REAL next_top = *top, next_bottom = *bottom;
+        for (const auto &item : m_layout_manager->intersectItems({ 0, *top, width, *bottom - *top })) {
+            next_top = min(next_top, item->rect().Y - margin);
+            next_bottom = max(next_bottom, item->rect().GetBottom() + margin);
+        }
+        if (next_top == *top && next_bottom == *bottom)
+            break;
+        *top = next_top;
+        *bottom = next_bottom;
+    }
+    m_damage.add(toDamageRect({ 0, *top, width, *bottom - *top }));
 }
 
 void ThumbnailWindowBase::setSelected(const LayoutItem *item)
@@ -273,17 +763,7 @@ void ThumbnailWindowBase::setSelected(const LayoutItem *item)
 
     const UIParam *ui = globalData()->UI();
 
-    // calculate dirty region
-    const int margin = ui->selectFrameMargin() + (ui->selectFrameWidth() / 2) + 1;
-    if (m_selected) {
-        RectF rect = m_selected->rect();
-        rect.Inflate(margin, margin);
-        m_dirty_region.Xor(rect);
-    }
-    RectF rect = item->rect();
-    rect.Inflate(margin, margin);
-    m_dirty_region.Xor(rect);
-
+    // only record the change, frames in between are skipped when selection changes quickly
     m_selected = item;
 
     // scroll view if selected item is out of view
@@ -300,15 +780,100 @@ void ThumbnailWindowBase::setSelected(const LayoutItem *item)
         updateView(next_view_rect);
     }
 
+    requestFrame();
+}
+
+void ThumbnailWindowBase::requestFrame()
+{
+    globalData()->frameScheduler()->requestFrame(this, [this]() { renderFrame(); });
+}
+
+void ThumbnailWindowBase::renderFrame()
+{
+    // damage select frame of the last drawn and the current selection
+    if (m_presented_selected != m_selected) {
+        if (m_presented_selected)
+            addDamage(m_presented_selected->rect());
+        if (m_selected)
+            addDamage(m_selected->rect());
+    }
+
     updateBitmap();
     requestRepaint();
 }
 
+void ThumbnailWindowBase::addDamage(const RectF &item_rect)
+{
+    // include select frame around the item
+    const UIParam *ui = globalData()->UI();
+    const REAL margin = ui->selectFrameMargin() + (ui->selectFrameWidth() / 2) + 1;
+    RectF rect = item_rect;
+    rect.Inflate(margin, margin);
+    m_damage.add(toDamageRect(rect));
+}
+
+bool ThumbnailWindowBase::useCompactLayout() const
+{
+    const int threshold = config()->compactModeThreshold();
+    return config()->compactMode()
+            || (threshold > 0 && globalData()->windows().size() >= static_cast<size_t>(threshold));
+}
+
+std::vector<const LayoutItem *> ThumbnailWindowBase::damagedItems() const
+{
+    std::vector<const LayoutItem *> items;
+    if (!m_layout_manager)
+        return items;
+
+    for (const DamageRect &rect : m_damage) {
+        const std::vector<const LayoutItem *> &rect_items =
+                m_layout_manager->intersectItems(toRectF(rect));
+        items.insert(items.end(), rect_items.begin(), rect_items.end());
+    }
+    // an item may intersect more than one damaged rect
+    std::sort(items.begin(), items.end());
+    items.erase(std::unique(items.begin(), items.end()), items.end());
+    return items;
+}
+
+void ThumbnailWindowBase::scheduleDetails()
+{
+    FrameScheduler *scheduler = globalData()->frameScheduler();
+    if (!m_layout_manager)
+        return;
+
+    for (size_t i = 0; const LayoutItem *item = m_layout_manager->itemAt(i); ++i) {
+        if (item->detailsLoaded())
+            continue;
+
+        scheduler->post(this, [this, item]() {
+            item->loadDetails();
+            addDamage(item->rect());
+            requestFrame();
+        });
+    }
+}
+
+void ThumbnailWindowBase::markPresented()
+{
+    metrics()->markStage(Metrics::StagePresent);
+    if (m_show_time == 0)
+        return;
+
+    const uint64_t elapsed = currentMicroseconds() - m_show_time;
+    metrics()->firstPaint().record(elapsed);
+    if (m_rehydrating)
+        metrics()->rehydration().record(elapsed);
+    m_show_time = 0;
+    m_rehydrating = false;
+}
+
 void ThumbnailWindowBase::beforeDrawContent(Graphics *graphics)
 {
-    // fill dirty region with green
-    Gdiplus::SolidBrush back_brush(0xFF00FF00);
-    graphics->FillRegion(&back_brush, &m_dirty_region);
+    // replace damaged rects with clear color
+    const uint32_t clear_color = PixelCompositor::premultiply(clearColor());
+    for (const DamageRect &rect : m_damage)
+        PixelCompositor::fill(m_pixels, rect.left, rect.top, rect.right, rect.bottom, clear_color);
 }
 
 void ThumbnailWindowBase::drawContent(Graphics *graphics)
@@ -316,49 +881,45 @@ void ThumbnailWindowBase::drawContent(Graphics *graphics)
     const UIParam *ui = globalData()->UI();
 
     // draw item info
-    RectF bound_rect;
-    m_dirty_region.GetBounds(&bound_rect, graphics);
-    std::vector<const LayoutItem *> items = m_layout_manager->intersectItems(bound_rect);
-    for (const auto &item : items) {
-        if (m_dirty_region.IsVisible(item->rect()))
-            item->drawInfo(graphics);
-    }
+    for (const auto &item : damagedItems())
+        item->drawInfo(graphics, m_pixels);
 
-    // draw select frame
-    if (m_selected && m_dirty_region.IsVisible(m_selected->rect())) {
+    // draw select frame, the pen is centered on the frame rect
+    if (m_selected && m_damage.intersects(toDamageRect(m_selected->rect()))) {
+        const REAL pen_width = ui->selectFrameWidth();
         RectF select_rect = m_selected->rect();
-        select_rect.Inflate(ui->selectFrameMargin(), ui->selectFrameMargin());
-        Gdiplus::Pen select_pen(Gdiplus::Color(ui->selectFrameColor()), ui->selectFrameWidth());
-        graphics->DrawRectangle(&select_pen, select_rect);
+        select_rect.Inflate(ui->selectFrameMargin() + pen_width / 2,
+                ui->selectFrameMargin() + pen_width / 2);
+        const DamageRect frame = toPixelRect(select_rect);
+        graphics->Flush(Gdiplus::FlushIntentionSync);
+        PixelCompositor::stroke(m_pixels, frame.left, frame.top, frame.right, frame.bottom,
+                max(static_cast<int>(std::lround(pen_width)), 1),
+                PixelCompositor::premultiply(ui->selectFrameColor()));
     }
 }
 
 void ThumbnailWindowBase::afterDrawContent(Graphics *graphics)
 {
-    m_dirty_region.MakeEmpty();
+    m_damage.clear();
+    m_presented_selected = m_selected;
 }
 
-void ThumbnailWindowBase::handlePaint(HWND hwnd, HDC hdc)
+void ThumbnailWindowBase::handlePaint(HWND hwnd, HDC hdc, const RECT &paint_rect)
 {
     if (hwnd == m_hwnd.get()) {
         // draw background window
         Graphics graphics(hdc);
         graphics.Clear(globalData()->UI()->backgroundColor());
     } else if (hwnd == m_fore_hwnd.get()) {
-        // draw thumbnail
-        if (!m_thumbnail_updated && m_layout_manager) {
-            const std::vector<const LayoutItem *> items = m_layout_manager->intersectItems(m_view_rect);
-            for (const auto &item : items) {
-                if (m_view_rect.IntersectsWith(item->thumbnailRect())) {
-                    RectF rect = item->thumbnailRect();
-                    rect.Offset(-m_view_rect.X + 1, -m_view_rect.Y + 1);
-                    item->windowHandle()->showThumbnail(m_fore_hwnd.get(), rect);
-                }
-            }
-            m_thumbnail_updated = true;
-        }
-        BitBlt(hdc, 0, 0, m_rect.Width, m_rect.Height,
-                m_dc.get(), m_view_rect.X, m_view_rect.Y, SRCCOPY);
+        // update thumbnails in one batch per frame
+        if (!m_thumbnail_updated)
+            updateThumbnails();
+        // copy only the invalidated part of the backing bitmap
+        BitBlt(hdc, paint_rect.left, paint_rect.top,
+                paint_rect.right - paint_rect.left, paint_rect.bottom - paint_rect.top,
+                m_dc.get(), static_cast<int>(m_view_rect.X) + paint_rect.left,
+                static_cast<int>(m_view_rect.Y) + paint_rect.top, SRCCOPY);
+        markPresented();
     }
 }
 
@@ -383,13 +944,15 @@ void ThumbnailWindowBase::handleMouseWheel(short delta, int x, int y)
     if (next_view_rect.GetBottom() > layout_rect.GetBottom())
         next_view_rect.Y = layout_rect.GetBottom() - m_view_rect.Height;
 
+    // wheel bursts are merged into one frame
     updateView(next_view_rect);
-    requestRepaint();
+    requestFrame();
 }
 
 void ThumbnailWindowBase::handleModUp(WPARAM mod)
 {
-    if (!m_keep_showing && mod == MOD_ALT)
+    // notification may arrive twice when alt is released during show
+    if (visible() && !m_keep_showing && mod == MOD_ALT)
         activateSelected();
 }
 
@@ -403,6 +966,16 @@ LRESULT GroupThumbnailWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
             handleRButtonUp(GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
             return 0;
 
+        case WM_TIMER:
+            if (wParam == TimerIDShowDelay) {
+                // alt is still held, the delay is not part of the key to present latency
+                if (m_show_pending)
+                    metrics()->beginKeyEvent(currentMicroseconds());
+                showPendingNow();
+                return 0;
+            }
+            break;
+
         default:
             break;
         }
@@ -410,6 +983,15 @@ LRESULT GroupThumbnailWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
     return ThumbnailWindowBase::handleMessage(hwnd, uMsg, wParam, lParam);
 }
 
+void GroupThumbnailWindow::show(bool keep)
+{
+    const bool was_visible = visible();
+    ThumbnailWindowBase::show(keep);
+    // an uncloaked view keeps its layout, the list still follows the selection
+    if (!was_visible && visible())
+        scheduleListUpdate();
+}
+
 void GroupThumbnailWindow::activateSelected()
 {
     if (!m_selected)
@@ -417,7 +999,7 @@ void GroupThumbnailWindow::activateSelected()
 
     // if more than one window in the group, do not activate directly
     if (multipleWindowsInGroup(m_selected->windowHandle()->group())) {
-        ListThumbnailWindow *list = globalData()->listWindow();
+        ListThumbnailWindow *list = currentListWindow();
         if (list)
             list->activateSelected();
         return;
@@ -426,6 +1008,60 @@ void GroupThumbnailWindow::activateSelected()
     globalData()->activateWindow(m_selected->windowHandle());
 }
 
+bool GroupThumbnailWindow::showDelayed(HMONITOR monitor)
+{
+    const int delay = config()->showDelay();
+    if (delay <= 0 || visible() || !monitor)
+        return false;
+
+    if (!created() && !create(globalData()->hInstance()))
+        return false;
+    // notified once for the tap or the view shown after the delay
+    if (!globalData()->keyboardHook()->modUpNotifyOnce(m_hwnd.get(), MOD_ALT))
+        return false;
+
+    m_show_pending = true;
+    m_pending_monitor = monitor;
+    SetTimer(m_hwnd.get(), TimerIDShowDelay, delay, nullptr);
+
+    // alt may be released before the hotkey command reached the render thread
+    if (!(GetAsyncKeyState(VK_MENU) & 0x8000))
+        PostMessage(m_hwnd.get(), WMAPP_MODUP, MOD_ALT, 0);
+    return true;
+}
+
+void GroupThumbnailWindow::showPendingNow()
+{
+    if (!m_show_pending)
+        return;
+
+    cancelPendingShow();
+    if (!globalData()->update(m_pending_monitor))
+        return;
+    show(false);
+    if (visible())
+        selectNext();
+}
+
+void GroupThumbnailWindow::cancelPendingShow()
+{
+    if (!m_show_pending)
+        return;
+
+    // a timer message posted already finds nothing pending
+    KillTimer(m_hwnd.get(), TimerIDShowDelay);
+    m_show_pending = false;
+}
+
+void GroupThumbnailWindow::switchToRecentGroup()
+{
+    // last snapshot is enough to toggle, enumerate only if it has nothing to switch to
+    const WindowHandle *window = globalData()->recentWindowOfOtherGroup(m_pending_monitor);
+    if (!window && globalData()->update(m_pending_monitor))
+        window = globalData()->recentWindowOfOtherGroup(m_pending_monitor);
+    globalData()->activateWindow(window);
+}
+
 void GroupThumbnailWindow::initializeLayout()
 {
     updateView({});
@@ -433,8 +1069,14 @@ void GroupThumbnailWindow::initializeLayout()
     const RectF &limit_rect = globalData()->groupWindowLimitRect();
 
     // initialize layout and align items
-    if (!m_layout_manager) {
-        m_layout_manager = std::make_unique<GridLayoutManager>(m_monitor, limit_rect.Width);
+    const bool compact = useCompactLayout();
+    if (!m_layout_manager || m_compact_layout != compact) {
+        if (compact) {
+            m_layout_manager = std::make_unique<CompactLayoutManager>(m_monitor, limit_rect.Width, false);
+        } else {
+            m_layout_manager = std::make_unique<GridLayoutManager>(m_monitor, limit_rect.Width);
+        }
+        m_compact_layout = compact;
     } else {
         m_layout_manager->reinitialize(m_monitor, limit_rect.Width);
     }
@@ -448,9 +1090,12 @@ void GroupThumbnailWindow::initializeLayout()
         }
     }
     m_selected = m_layout_manager->itemAt(0);
+    m_presented_selected = nullptr;
     m_layout_manager->alignItems();
 
-    updateListWindow();
+    // previous update was cancelled with the old layout
+    m_list_update_pending = false;
+    scheduleListUpdate();
 
     // calculate window rect
     const RectF &layout_rect = m_layout_manager->rect();
@@ -469,7 +1114,7 @@ void GroupThumbnailWindow::setSelected(const LayoutItem *item)
     const LayoutItem *prev_selected = m_selected;
     ThumbnailWindowBase::setSelected(item);
     if (prev_selected != m_selected)
-        updateListWindow();
+        scheduleListUpdate();
 }
 
 void GroupThumbnailWindow::beforeDrawContent(Graphics *graphics)
@@ -477,27 +1122,23 @@ void GroupThumbnailWindow::beforeDrawContent(Graphics *graphics)
     ThumbnailWindowBase::beforeDrawContent(graphics);
 
     const UIParam *ui = globalData()->UI();
-
-    RectF bound_rect;
-    m_dirty_region.GetBounds(&bound_rect, graphics);
-    std::vector<const LayoutItem *> items = m_layout_manager->intersectItems(bound_rect);
-    Gdiplus::SolidBrush brush{Gdiplus::Color(ui->gridItemShadowColor())};
+    const uint32_t shadow_color = PixelCompositor::premultiply(ui->gridItemShadowColor());
+    const uint32_t clear_color = PixelCompositor::premultiply(clearColor());
 
     const float scale = globalData()->monitorScale();
-    for (const auto &item : items) {
-        if (!m_dirty_region.IsVisible(item->rect()))
-            continue;
-
+    for (const auto &item : damagedItems()) {
         // if more than one window in the group, draw a fake shadow
         if (multipleWindowsInGroup(item->windowHandle()->group())) {
             RectF rect = item->rect();
             rect.Offset(10 * scale, 10 * scale);
-            brush.SetColor(Gdiplus::Color(ui->gridItemShadowColor()));
-            graphics->FillRectangle(&brush, rect);
+            DamageRect shadow = toPixelRect(rect);
+            PixelCompositor::blend(m_pixels, shadow.left, shadow.top, shadow.right, shadow.bottom,
+                    shadow_color);
             rect.Width -= 7 * scale;
             rect.Height -= 7 * scale;
-            brush.SetColor(0xFF00FF00);
-            graphics->FillRectangle(&brush, rect);
+            shadow = toPixelRect(rect);
+            PixelCompositor::fill(m_pixels, shadow.left, shadow.top, shadow.right, shadow.bottom,
+                    clear_color);
         }
     }
 }
@@ -508,7 +1149,7 @@ void GroupThumbnailWindow::handleMouseWheel(short delta, int x, int y)
         PointF native_point(x - m_rect.X, y - m_rect.Y);
         RectF select_rect = m_selected->rect();
         select_rect.Offset(-m_view_rect.X, -m_view_rect.Y);
-        ListThumbnailWindow *list = globalData()->listWindow();
+        ListThumbnailWindow *list = currentListWindow();
         if (select_rect.Contains(native_point) && list) {
             if (delta > 0) {
                 list->selectPrev();
@@ -531,6 +1172,17 @@ void GroupThumbnailWindow::handleLButtonUp(int x, int y)
         activateSelected();
 }
 
+void GroupThumbnailWindow::handleModUp(WPARAM mod)
+{
+    if (m_show_pending && mod == MOD_ALT) {
+        // released within the show delay
+        cancelPendingShow();
+        switchToRecentGroup();
+        return;
+    }
+    ThumbnailWindowBase::handleModUp(mod);
+}
+
 void GroupThumbnailWindow::handleRButtonUp(int x, int y)
 {
     const LayoutItem *item = m_layout_manager->itemFromPoint(PointF(x, y));
@@ -538,36 +1190,235 @@ void GroupThumbnailWindow::handleRButtonUp(int x, int y)
         return;
 
     setSelected(item);
-    ListThumbnailWindow *list = globalData()->listWindow();
+    ListThumbnailWindow *list = currentListWindow();
     if (list)
         list->activateSelected();
 }
 
+ListThumbnailWindow *GroupThumbnailWindow::currentListWindow()
+{
+    if (m_list_update_pending && visible())
+        updateListWindow();
+
+    // callers act on the list of the selected group
+    ListThumbnailWindow *list = globalData()->listWindow();
+    if (list)
+        list->applyPendingGroup();
+    return list;
+}
+
+void GroupThumbnailWindow::scheduleListUpdate()
+{
+    if (m_list_update_pending)
+        return;
+
+    // run before remaining details, the list follows selection closely
+    m_list_update_pending = true;
+    globalData()->frameScheduler()->post(this, [this]() {
+        if (m_list_update_pending)
+            updateListWindow();
+    }, true);
+}
+
 void GroupThumbnailWindow::updateListWindow()
 {
+    m_list_update_pending = false;
+
     ListThumbnailWindow *list = globalData()->listWindow();
     if (!list || !m_selected)
         return;
 
     list->setGroup(m_selected->windowHandle()->group());
-    if (!list->visible())
+    if (!visible()) {
+        // group window is rendered while cloaked
+        list->prerender();
+    } else if (!list->visible()) {
         list->show(m_keep_showing);
+    }
+}
+
+void GroupThumbnailWindow::releaseLayout()
+{
+    if (!created() || visible())
+        return;
+
+    m_list_update_pending = false;
+    ThumbnailWindowBase::releaseLayout();
 }
 
 // --------------------ListThumbnailWindow---------------------
 
+LRESULT ListThumbnailWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+    if (hwnd == m_hwnd.get() && uMsg == WM_TIMER && wParam == TimerIDDwell) {
+        applyPendingGroup();
+        return 0;
+    }
+    return ThumbnailWindowBase::handleMessage(hwnd, uMsg, wParam, lParam);
+}
+
+void ListThumbnailWindow::hide()
+{
+    if (m_group_pending) {
+        KillTimer(m_hwnd.get(), TimerIDDwell);
+        m_group = m_pending_group;
+        m_group_pending = false;
+    }
+    ThumbnailWindowBase::hide();
+}
+
+void ListThumbnailWindow::trim()
+{
+    if (visible())
+        return;
+    // cached surfaces are the largest part
+    clearCache();
+    ThumbnailWindowBase::trim();
+}
+
+void ListThumbnailWindow::releaseLayout()
+{
+    if (!created() || visible())
+        return;
+
+    clearCache();
+    ThumbnailWindowBase::releaseLayout();
+}
+
+void ListThumbnailWindow::activateSelected()
+{
+    // never activate a window of the group shown before
+    applyPendingGroup();
+    ThumbnailWindowBase::activateSelected();
+}
+
 void ListThumbnailWindow::setGroup(const WindowGroup &group)
 {
+    if (m_group_pending) {
+        KillTimer(m_hwnd.get(), TimerIDDwell);
+        m_group_pending = false;
+    }
     if (m_group == group)
         return;
 
-    m_group = group;
-    if (visible()) {
-        initializeLayout();
-        initializeBitmap();
-        updateBitmap(true);
+    // layout is built by show()
+    if (!visible()) {
+        m_group = group;
+        return;
+    }
+
+    m_pending_group = group;
+    m_group_pending = true;
+    if (m_cache.contains(group)) {
+        applyPendingGroup();
+        return;
+    }
+
+    // keep showing the current list until selection rests
+    SetTimer(m_hwnd.get(), TimerIDDwell, kDwellTime, nullptr);
+}
+
+void ListThumbnailWindow::applyPendingGroup()
+{
+    if (!m_group_pending)
+        return;
+
+    KillTimer(m_hwnd.get(), TimerIDDwell);
+    m_group_pending = false;
+    if (!visible()) {
+        m_group = m_pending_group;
+        return;
+    }
+
+    stashList();
+    m_group = m_pending_group;
+    if (restoreList(m_group)) {
+        // rows of the view may not have been drawn into the cached surface
+        updateBitmap();
         requestRepaint();
+        scheduleDetails();
+        return;
     }
+
+    initializeLayout();
+    metrics()->markStage(Metrics::StageLayout);
+    initializeBitmap();
+    updateBitmap(true);
+    requestRepaint();
+    scheduleDetails();
+}
+
+void ListThumbnailWindow::clearCache()
+{
+    m_cache.clear();
+}
+
+void ListThumbnailWindow::invalidate()
+{
+    // cached lists are drawn with the old settings too
+    clearCache();
+    ThumbnailWindowBase::invalidate();
+}
+
+bool ListThumbnailWindow::current() const
+{
+    return ThumbnailWindowBase::current() && m_layout_group == m_group;
+}
+
+void ListThumbnailWindow::stashList()
+{
+    if (!m_layout_manager || !m_surface)
+        return;
+
+    // the cached surface must be complete, draw damage of loaded details now
+    updateBitmap();
+    globalData()->frameScheduler()->cancel(this);
+    updateView({});
+
+    CachedList cached;
+    cached.layout_manager = std::move(m_layout_manager);
+    cached.selected = m_selected;
+    cached.bitmap = std::move(m_bitmap);
+    cached.dc = std::move(m_dc);
+    cached.surface = std::move(m_surface);
+    cached.pixels = m_pixels;
+    cached.bitmap_size = m_bitmap_size;
+    cached.drawn_top = m_drawn_top;
+    cached.drawn_bottom = m_drawn_bottom;
+    m_cache.put(m_group, std::move(cached));
+
+    m_selected = nullptr;
+    m_presented_selected = nullptr;
+    m_pixels = PixelSurface();
+    m_bitmap_size = { 0, 0 };
+    m_drawn_top = m_drawn_bottom = 0;
+    m_damage.clear();
+}
+
+bool ListThumbnailWindow::restoreList(const WindowGroup &group)
+{
+    CachedList cached;
+    if (!m_cache.take(group, &cached))
+        return false;
+
+    m_layout_manager = std::move(cached.layout_manager);
+    m_layout_group = group;
+    m_bitmap = std::move(cached.bitmap);
+    m_dc = std::move(cached.dc);
+    m_surface = std::move(cached.surface);
+    m_pixels = cached.pixels;
+    m_bitmap_size = cached.bitmap_size;
+    m_drawn_top = cached.drawn_top;
+    m_drawn_bottom = cached.drawn_bottom;
+
+    m_rect = globalData()->listWindowLimitRect();
+    updateView({ 0, 0, m_rect.Width, m_rect.Height });
+
+    // the surface was drawn with this selection, start from the top again
+    m_selected = cached.selected;
+    m_presented_selected = cached.selected;
+    setSelected(m_layout_manager->itemAt(0));
+    return true;
 }
 
 void ListThumbnailWindow::initializeLayout()
@@ -576,16 +1427,24 @@ void ListThumbnailWindow::initializeLayout()
 
     m_rect = globalData()->listWindowLimitRect();
 
-    if (!m_layout_manager) {
-        m_layout_manager = std::make_unique<ListLayoutManager>(m_monitor, m_rect.Width);
+    const bool compact = useCompactLayout();
+    if (!m_layout_manager || m_compact_layout != compact) {
+        if (compact) {
+            m_layout_manager = std::make_unique<CompactLayoutManager>(m_monitor, m_rect.Width, true);
+        } else {
+            m_layout_manager = std::make_unique<ListLayoutManager>(m_monitor, m_rect.Width);
+        }
+        m_compact_layout = compact;
     } else {
         m_layout_manager->reinitialize(m_monitor, m_rect.Width);
     }
+    m_layout_group = m_group;
     for (const auto &window : globalData()->windowsFromGroup(m_group)) {
         if (window->monitor() == m_monitor)
             m_layout_manager->addItem(window);
     }
     m_selected = m_layout_manager->itemAt(0);
+    m_presented_selected = nullptr;
     m_layout_manager->alignItems();
 
     updateView({ 0, 0, m_rect.Width, m_rect.Height });
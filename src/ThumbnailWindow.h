@@ -2,12 +2,14 @@
 
 #include "LayoutManager.h"
 #include "WindowHandle.h"
+#include "utils/DamageTracker.h"
+#include "utils/LruCache.h"
+#include "utils/PairHash.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
-using Gdiplus::Region;
-
 class ThumbnailWindowBase
 {
 public:
@@ -16,6 +18,8 @@ public:
 
     HWND hwnd() const { return m_hwnd.get(); }
     HWND foreHwnd() const { return m_fore_hwnd.get(); }
+    // window that shows content and thumbnails
+    HWND surfaceHwnd() const { return m_layered_surface ? m_hwnd.get() : m_fore_hwnd.get(); }
     bool visible() const { return m_visible; }
 
     void selectNext();
@@ -28,21 +32,70 @@ public:
     virtual void show(bool keep);
     virtual void hide();
     virtual void activateSelected();
+    // render while cloaked, the next show only uncloaks
+    void prerender();
+    // release surface and item details of a hidden view, the next show draws them again
+    virtual void trim();
+    // drop work and layout of a hidden view, its items refer to windows of the last snapshot
+    virtual void releaseLayout();
+    // Configure::SettingChange bits replaced by a reload, a visible view keeps its surface
+    // until it is shown again
+    void refreshSettings(unsigned int changes);
 
 protected:
+    enum TimerID
+    {
+        TimerIDSettle = 1,
+        TimerIDNext  // first id of derived windows
+    };
+
+    bool created() const { return m_hwnd && (m_layered_surface || m_fore_hwnd); }
+    // border of window which is not a part of the surface
+    int border() const { return m_layered_surface ? 0 : 1; }
+    Gdiplus::ARGB clearColor() const;
+
+    // cloaked windows are rendered for the current snapshot, monitor and settings
+    virtual bool current() const;
+    // rendered surfaces no longer match the settings
+    virtual void invalidate() { m_stale = true; }
+    // hide windows waiting cloaked for the next show
+    void hideCloaked();
+    bool render();
+    void placeWindows();
+    void setCloaked(bool cloaked);
+
     void requestRepaint(bool repaint_background = false);
+    void presentLayeredSurface();
+    // render pending state changes in the next frame
+    void requestFrame();
+    void renderFrame();
     void initializeBitmap();
     void updateBitmap(bool redraw_all = false);
+    // the bitmap of a compact layout is drawn around the view, rows scrolled into view
+    // are damaged here
+    void exposeView();
+    void addRowDamage(REAL *top, REAL *bottom);
+    void addDamage(const RectF &rect);
+    std::vector<const LayoutItem *> damagedItems() const;
+    // fill in item details in later slices after the first frame
+    void scheduleDetails();
+    void markPresented();
 
     virtual void initializeLayout() = 0;
+    // icon and title only, when asked or there are too many windows for thumbnails
+    bool useCompactLayout() const;
     virtual void setSelected(const LayoutItem *item);
     virtual void updateView(const RectF &next_view_rect);
+    // thumbnails are replaced by placeholders while the view scrolls fast
+    void trackScroll(REAL distance);
+    void handleScrollSettled();
+    void updateThumbnails();
     virtual void beforeDrawContent(Graphics *graphics);
     virtual void drawContent(Graphics *graphics);
     virtual void afterDrawContent(Graphics *graphics);
 
     // handle events
-    virtual void handlePaint(HWND hwnd, HDC hdc);
+    virtual void handlePaint(HWND hwnd, HDC hdc, const RECT &paint_rect);
     virtual void handleLButtonUp(int x, int y);
     virtual void handleMouseWheel(short delta, int x, int y);
     virtual void handleModUp(WPARAM mod);
@@ -50,46 +103,138 @@ protected:
     std::unique_ptr<HWND__, decltype(&DestroyWindow)> m_hwnd = { nullptr, DestroyWindow };
     std::unique_ptr<HWND__, decltype(&DestroyWindow)> m_fore_hwnd =  { nullptr, DestroyWindow };
     bool m_visible = false;
+    bool m_cloaked = false;  // shown but cloaked by DWM
+    uint64_t m_snapshot_version = 0;
+    bool m_stale = false;  // settings changed since the last render
+    bool m_layered_surface = false;  // single window with per-pixel alpha
     bool m_keep_showing = false;
+    uint64_t m_show_time = 0;  // reset after the first present
+    bool m_rehydrating = false;  // trimmed since the last present
     HMONITOR m_monitor = nullptr;
     RectF m_rect;
     RectF m_view_rect;
 
     std::unique_ptr<LayoutManager> m_layout_manager = nullptr;
+    bool m_compact_layout = false;  // m_layout_manager is a CompactLayoutManager
     const LayoutItem *m_selected = nullptr;
+    const LayoutItem *m_presented_selected = nullptr;  // select frame in the bitmap
 
-    std::unique_ptr<HDC__, decltype(&DeleteDC)> m_dc = { nullptr, DeleteDC };
+    // 32 bit premultiplied DIB, drawn by GDI+ through m_surface
     std::unique_ptr<HBITMAP__, decltype(&DeleteObject)> m_bitmap = { nullptr, DeleteObject };
-    Region m_dirty_region;
+    std::unique_ptr<HDC__, decltype(&DeleteDC)> m_dc = { nullptr, DeleteDC };
+    std::unique_ptr<Gdiplus::Bitmap> m_surface = nullptr;
+    PixelSurface m_pixels;  // bits of m_bitmap, filled and blended without GDI+
+    SIZE m_bitmap_size = { 0, 0 };
+    DamageTracker m_damage;
+    REAL m_drawn_top = 0;  // rows of the bitmap drawn since the last full redraw
+    REAL m_drawn_bottom = 0;
+    DamageTracker m_present_damage;  // drawn but not yet presented, in layout coordinates
     bool m_thumbnail_updated = false;
+    bool m_fast_scrolling = false;
+    uint64_t m_last_scroll_time = 0;
+
+    // thumbnails currently shown, sorted by source window
+    struct ThumbnailPlacement
+    {
+        HWND source;
+        RECT rect;
+    };
+    std::vector<ThumbnailPlacement> m_placements;
 };
 
 class GroupThumbnailWindow : public ThumbnailWindowBase
 {
 public:
     LRESULT handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) override;
+    void show(bool keep) override;
     void activateSelected() override;
+    void releaseLayout() override;
+
+    // wait for the show delay before showing, alt released earlier switches to the
+    // recent group without rendering. false if the view is shown at once instead
+    bool showDelayed(HMONITOR monitor);
+    bool showPending() const { return m_show_pending; }
+    // show a waiting view now, with the selection of its first press
+    void showPendingNow();
+    void cancelPendingShow();
 
 private:
+    enum GroupTimerID
+    {
+        TimerIDShowDelay = TimerIDNext
+    };
+
     void initializeLayout() override;
     void setSelected(const LayoutItem *item) override;
     void beforeDrawContent(Graphics *graphics) override;
     void handleMouseWheel(short delta, int x, int y) override;
     void handleLButtonUp(int x, int y) override;
+    void handleModUp(WPARAM mod) override;
 
     void handleRButtonUp(int x, int y);
+    void switchToRecentGroup();
 
+    // list window is updated in a later slice, get it with pending update applied
+    ListThumbnailWindow *currentListWindow();
+    void scheduleListUpdate();
     void updateListWindow();
+
+    bool m_list_update_pending = false;
+    bool m_show_pending = false;
+    HMONITOR m_pending_monitor = nullptr;
 };
 
 class ListThumbnailWindow : public ThumbnailWindowBase
 {
 public:
+    ListThumbnailWindow() : m_cache(kCacheSize) {}
+
+    LRESULT handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) override;
+    void hide() override;
+    void activateSelected() override;
+    void trim() override;
+    void releaseLayout() override;
+
+    // a cached list is shown at once, otherwise the list is built when selection rests on group
     void setGroup(const WindowGroup &group);
+    // build the list of a group that is still waiting for selection to rest
+    void applyPendingGroup();
+    // cached layouts refer to windows of the last update
+    void clearCache();
 
 private:
+    enum ListTimerID
+    {
+        TimerIDDwell = TimerIDNext
+    };
+    static constexpr UINT kDwellTime = 120;  // milliseconds
+    static constexpr size_t kCacheSize = 8;
+
+    // layout and rendered surface of a group, swapped with the window's own
+    struct CachedList
+    {
+        std::unique_ptr<LayoutManager> layout_manager = nullptr;
+        const LayoutItem *selected = nullptr;
+        std::unique_ptr<HBITMAP__, decltype(&DeleteObject)> bitmap = { nullptr, DeleteObject };
+        std::unique_ptr<HDC__, decltype(&DeleteDC)> dc = { nullptr, DeleteDC };
+        std::unique_ptr<Gdiplus::Bitmap> surface = nullptr;
+        PixelSurface pixels;
+        SIZE bitmap_size = { 0, 0 };
+        REAL drawn_top = 0;
+        REAL drawn_bottom = 0;
+    };
+
+    bool current() const override;
+    void invalidate() override;
     void initializeLayout() override;
     void handleLButtonUp(int x, int y) override;
 
+    void stashList();
+    bool restoreList(const WindowGroup &group);
+
     WindowGroup m_group;
+    WindowGroup m_layout_group;  // group of current layout
+    WindowGroup m_pending_group;
+    bool m_group_pending = false;
+    LruCache<WindowGroup, CachedList> m_cache;
 };
@@ -19,7 +19,8 @@ void UIParam::update(REAL scale)
 
     m_list_window_width_limit = m_item_h_margin * 2 + m_list_layout_param.item_max_width;
 
-    m_item_font_name = std::wstring(config()->fontFamily().begin(), config()->fontFamily().end());
+    const char *font_family = config()->fontFamily();
+    m_item_font_name = std::wstring(font_family, font_family + strlen(font_family));
     m_item_font_size = config()->fontSize() * scale;
 
     m_select_frame_margin = 10 * scale;
@@ -58,33 +58,39 @@ WindowHandle::WindowHandle(HWND hwnd)
 WindowHandle::WindowHandle(WindowHandle &&other)
     : m_hwnd(other.m_hwnd)
     , m_icon(std::move(other.m_icon))
+    , m_icon_loaded(other.m_icon_loaded)
     , m_minimized(other.m_minimized)
     , m_rect(other.m_rect)
     , m_title(std::move(other.m_title))
     , m_exe_path(std::move(other.m_exe_path))
     , m_monitor(other.m_monitor)
-    , m_thumbnails(std::move(other.m_thumbnails))
 {
     other.m_hwnd = nullptr;
     other.m_icon = nullptr;
 }
 
-WindowHandle::~WindowHandle()
+bool WindowHandle::sameAttributes(const WindowHandle &other) const
 {
-    for (auto &pair : m_thumbnails)
-        DwmUnregisterThumbnail(pair.second);
+    return m_hwnd == other.m_hwnd && m_minimized == other.m_minimized
+            && m_rect.Equals(other.m_rect) && m_monitor == other.m_monitor
+            && m_title == other.m_title && m_exe_path == other.m_exe_path;
 }
 
 void WindowHandle::activate() const
 {
-    if (m_minimized) {
+    activate(m_hwnd);
+}
+
+void WindowHandle::activate(HWND hwnd)
+{
+    if (IsIconic(hwnd)) {
         WINDOWPLACEMENT placement = { sizeof(WINDOWPLACEMENT) };
-        GetWindowPlacement(m_hwnd, &placement);
+        GetWindowPlacement(hwnd, &placement);
         if (placement.flags & WPF_RESTORETOMAXIMIZED) {
             // window is maximized before minimized, show maximized
-            ShowWindow(m_hwnd, SW_SHOWMAXIMIZED);
+            ShowWindow(hwnd, SW_SHOWMAXIMIZED);
         } else {
-            ShowWindow(m_hwnd, SW_RESTORE);
+            ShowWindow(hwnd, SW_RESTORE);
         }
     }
 
@@ -93,7 +99,7 @@ void WindowHandle::activate() const
     input.mi = { 0 };
     SendInput(1, &input, sizeof(input));
 
-    SetForegroundWindow(m_hwnd);
+    SetForegroundWindow(hwnd);
 }
 
 void WindowHandle::updateAttributes()
@@ -121,13 +127,16 @@ void WindowHandle::updateAttributes()
 
     m_title = getWindowTitle(m_hwnd);
 
-    m_exe_path = getProcessPath(getWidnowPid(m_hwnd));
-    // if app runs under ApplicationFrameHost.exe, search process from its child windows
-    if (m_exe_path == L"C:\\Windows\\System32\\ApplicationFrameHost.exe") {
-        std::array<DWORD, 2> info = { getWidnowPid(m_hwnd), 0 };
-        EnumChildWindows(m_hwnd, enumChildWindowsProc, reinterpret_cast<LPARAM>(&info));
-        m_exe_path = getProcessPath(info[1]);
-    }
+    m_exe_path = exePathOf(m_hwnd);
+
+    m_monitor = MonitorFromWindow(m_hwnd, MONITOR_DEFAULTTONEAREST);
+}
+
+void WindowHandle::loadIcon()
+{
+    if (!m_hwnd || m_icon_loaded)
+        return;
+    m_icon_loaded = true;
 
     HICON icon = reinterpret_cast<HICON>(GetClassLongPtr(m_hwnd, GCLP_HICON));
     if (!icon && !m_exe_path.empty()) {
@@ -138,45 +147,12 @@ void WindowHandle::updateAttributes()
         }
     }
     m_icon = { icon, DestroyIcon };
-
-    m_monitor = MonitorFromWindow(m_hwnd, MONITOR_DEFAULTTONEAREST);
-}
-
-void WindowHandle::showThumbnail(HWND dst_hwnd, const RectF &dst_rect) const
-{
-    DWM_THUMBNAIL_PROPERTIES props = {};
-    auto it = m_thumbnails.find(dst_hwnd);
-    if (it == m_thumbnails.end()) {
-        HTHUMBNAIL thumbnail = nullptr;
-        if (DwmRegisterThumbnail(dst_hwnd, m_hwnd, &thumbnail) != S_OK)
-            return;
-
-        it = m_thumbnails.emplace(dst_hwnd, thumbnail).first;
-        props.dwFlags |= DWM_TNP_SOURCECLIENTAREAONLY;
-        props.fSourceClientAreaOnly = FALSE;
-    }
-
-    props.dwFlags |= DWM_TNP_RECTDESTINATION | DWM_TNP_VISIBLE;
-    props.rcDestination = {
-        static_cast<LONG>(std::ceil(dst_rect.X)),
-        static_cast<LONG>(std::ceil(dst_rect.Y)),
-        static_cast<LONG>(std::ceil(dst_rect.GetRight())),
-        static_cast<LONG>(std::ceil(dst_rect.GetBottom()))
-    };
-    props.fVisible = TRUE;
-    DwmUpdateThumbnailProperties(it->second, &props);
 }
 
-void WindowHandle::hideThumbnail(HWND dst_hwnd) const
+void WindowHandle::releaseIcon()
 {
-    auto it = m_thumbnails.find(dst_hwnd);
-    if (it == m_thumbnails.end())
-        return;
-
-    DWM_THUMBNAIL_PROPERTIES props = {};
-    props.dwFlags = DWM_TNP_VISIBLE;
-    props.fVisible = FALSE;
-    DwmUpdateThumbnailProperties(it->second, &props);
+    m_icon.reset();
+    m_icon_loaded = false;
 }
 
 bool WindowHandle::validWindow(HWND hwnd)
@@ -199,6 +175,18 @@ bool WindowHandle::validWindow(HWND hwnd)
     return true;
 }
 
+std::wstring WindowHandle::exePathOf(HWND hwnd)
+{
+    std::wstring exe_path = getProcessPath(getWidnowPid(hwnd));
+    // if app runs under ApplicationFrameHost.exe, search process from its child windows
+    if (exe_path == L"C:\\Windows\\System32\\ApplicationFrameHost.exe") {
+        std::array<DWORD, 2> info = { getWidnowPid(hwnd), 0 };
+        EnumChildWindows(hwnd, enumChildWindowsProc, reinterpret_cast<LPARAM>(&info));
+        exe_path = getProcessPath(info[1]);
+    }
+    return exe_path;
+}
+
 void WindowHandle::updateUWPIconCache()
 {
     decltype(s_UWP_icon_cache) new_cache;
@@ -211,6 +199,12 @@ void WindowHandle::updateUWPIconCache()
     s_UWP_icon_cache = std::move(new_cache);
 }
 
+void WindowHandle::clearUWPIconCache()
+{
+    // release memory of buckets too
+    decltype(s_UWP_icon_cache)().swap(s_UWP_icon_cache);
+}
+
 HICON WindowHandle::extractUWPIcon(const std::wstring &exe_path)
 {
     // hit cache
@@ -20,7 +20,6 @@ class WindowHandle
 public:
     WindowHandle(HWND hwnd);
     WindowHandle(WindowHandle &&other);
-    ~WindowHandle();
 
     HWND hwnd() const { return m_hwnd; }
     HICON icon() const { return m_icon.get(); }
@@ -30,27 +29,34 @@ public:
     const std::wstring &exePath() const { return m_exe_path; }
     HMONITOR monitor() const { return m_monitor; }
     WindowGroup group() const { return { m_exe_path, m_monitor }; }
+    // same window with the same attributes shown by views
+    bool sameAttributes(const WindowHandle &other) const;
 
     void activate() const;
+    // activate without taking a snapshot of window
+    static void activate(HWND hwnd);
     void updateAttributes();
-    void showThumbnail(HWND dst_hwnd, const RectF &dst_rect) const;
-    void hideThumbnail(HWND dst_hwnd) const;
+    // extracting icon is slow, it is loaded separately from other attributes
+    void loadIcon();
+    // loaded again by the next loadIcon()
+    void releaseIcon();
 
     static bool validWindow(HWND hwnd);
+    static std::wstring exePathOf(HWND hwnd);
     static void updateUWPIconCache();
+    static void clearUWPIconCache();
 
 private:
     static HICON extractUWPIcon(const std::wstring &exe_path);
 
     HWND m_hwnd = nullptr;
     std::unique_ptr<HICON__, decltype(&DestroyIcon)> m_icon = { nullptr, DestroyIcon };
+    bool m_icon_loaded = false;
     bool m_minimized = false;
     RectF m_rect;
     std::wstring m_title;
     std::wstring m_exe_path;
     HMONITOR m_monitor = nullptr;
 
-    mutable std::unordered_map<HWND, HTHUMBNAIL> m_thumbnails;
-
     static std::unordered_map<std::wstring, std::vector<BYTE>> s_UWP_icon_cache;
 };
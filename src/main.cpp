@@ -39,6 +39,12 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     }
     gRunningInstance = true;
 
+    // settings with errors keep their defaults
+    if (!config()->diagnostics().empty()) {
+        const std::wstring text = config()->diagnosticsText();
+        MessageBox(nullptr, text.c_str(), L"GroupTabBox Settings", MB_OK | MB_ICONWARNING);
+    }
+
     setAutoStart(L"GroupTabBox", config()->autoStart());
 
     SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE);
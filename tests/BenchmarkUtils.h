@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// run body repeatedly for at least the minimum time, seconds per call
+namespace bench {
+
+template<typename Body>
+double secondsPerCall(Body body, double min_seconds = 0.2)
+{
+    using Clock = std::chrono::steady_clock;
+    // warm up caches and branch predictors
+    body();
+
+    long long calls = 0;
+    const Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < min_seconds) {
+        for (int i = 0; i < 16; ++i)
+            body();
+        calls += 16;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return elapsed / calls;
+}
+
+// keep results alive without volatile stores in every loop
+template<typename T>
+void consume(const T &value)
+{
+    static const T *volatile sink = nullptr;
+    sink = &value;
+    (void)sink;
+}
+
+}  // namespace bench
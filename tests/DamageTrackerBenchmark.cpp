@@ -0,0 +1,50 @@
+#include "BenchmarkUtils.h"
+#include "utils/DamageTracker.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// damage of one frame: selection moves between two items and a few thumbnails update
+static std::vector<DamageRect> frameRects(std::mt19937 *random, int count)
+{
+    std::uniform_int_distribution<int> position(0, 1800);
+    std::uniform_int_distribution<int> size(20, 300);
+    std::vector<DamageRect> rects;
+    for (int i = 0; i < count; ++i) {
+        const int x = position(*random);
+        const int y = position(*random);
+        rects.push_back({ x, y, x + size(*random), y + size(*random) });
+    }
+    return rects;
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    std::printf("%-10s %14s %14s %14s\n", "rects", "add ns/rect", "query ns", "rects left");
+    for (int count : { 2, 8, 32, 128 }) {
+        const std::vector<DamageRect> rects = frameRects(&random, count);
+        const std::vector<DamageRect> queries = frameRects(&random, 256);
+
+        DamageTracker damage;
+        const double add_time = bench::secondsPerCall([&]() {
+            damage.clear();
+            for (const DamageRect &rect : rects)
+                damage.add(rect);
+            bench::consume(damage);
+        });
+
+        // one intersection test per layout item, as redraw walks the layout index
+        size_t hits = 0;
+        const double query_time = bench::secondsPerCall([&]() {
+            for (const DamageRect &rect : queries)
+                hits += damage.intersects(rect);
+            bench::consume(hits);
+        });
+
+        std::printf("%-10d %14.1f %14.1f %14zu\n", count, add_time * 1e9 / count,
+                query_time * 1e9 / queries.size(), damage.size());
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "TestUtils.h"
+#include "utils/DamageTracker.h"
+
+#include <algorithm>
+
+static bool hasRect(const DamageTracker &damage, const DamageRect &rect)
+{
+    return std::find(damage.begin(), damage.end(), rect) != damage.end();
+}
+
+static void testRect()
+{
+    const DamageRect a = { 0, 0, 10, 10 };
+    const DamageRect b = { 5, 5, 15, 15 };
+    const DamageRect c = { 10, 0, 20, 10 };
+
+    CHECK(a.intersects(b));
+    // right and bottom are exclusive
+    CHECK(!a.intersects(c));
+    CHECK(a.contains({ 2, 2, 8, 8 }));
+    CHECK(!a.contains(b));
+    CHECK_EQUAL(a.united(b), (DamageRect{ 0, 0, 15, 15 }));
+    CHECK_EQUAL(a.intersected(b), (DamageRect{ 5, 5, 10, 10 }));
+    CHECK(a.intersected(c).empty());
+    CHECK_EQUAL(a.united(DamageRect()), a);
+    CHECK_EQUAL(a.area(), 100);
+    CHECK_EQUAL((DamageRect{ 5, 5, 0, 0 }).area(), 0);
+
+    DamageRect moved = a;
+    moved.offset(3, -2);
+    CHECK_EQUAL(moved, (DamageRect{ 3, -2, 13, 8 }));
+}
+
+static void testAdd()
+{
+    DamageTracker damage;
+    CHECK(damage.empty());
+
+    damage.add({});
+    CHECK(damage.empty());
+
+    damage.add({ 0, 0, 10, 10 });
+    damage.add({ 2, 2, 5, 5 });
+    // contained rect adds nothing
+    CHECK_EQUAL(damage.size(), 1u);
+
+    damage.add({ 100, 100, 110, 110 });
+    // far rects are kept apart
+    CHECK_EQUAL(damage.size(), 2u);
+    CHECK(damage.intersects({ 104, 104, 106, 106 }));
+    CHECK(!damage.intersects({ 50, 50, 60, 60 }));
+
+    damage.add({ -10, -10, 200, 200 });
+    // a rect containing all others swallows them
+    CHECK_EQUAL(damage.size(), 1u);
+    CHECK_EQUAL(damage.bounds(), (DamageRect{ -10, -10, 200, 200 }));
+}
+
+static void testCoalesce()
+{
+    DamageTracker damage;
+    // union of neighbours costs no more than drawing both
+    damage.add({ 0, 0, 10, 10 });
+    damage.add({ 10, 0, 20, 10 });
+    CHECK_EQUAL(damage.size(), 1u);
+    CHECK(hasRect(damage, { 0, 0, 20, 10 }));
+
+    // overlapping rects are united once, not xored
+    damage.add({ 15, 0, 25, 10 });
+    CHECK_EQUAL(damage.size(), 1u);
+    CHECK(hasRect(damage, { 0, 0, 25, 10 }));
+
+    // a diagonal neighbour would waste area
+    damage.add({ 25, 10, 35, 20 });
+    CHECK_EQUAL(damage.size(), 2u);
+
+    // a bridge merges rects checked before it
+    damage.clear();
+    damage.add({ 0, 0, 10, 10 });
+    damage.add({ 20, 0, 30, 10 });
+    CHECK_EQUAL(damage.size(), 2u);
+    damage.add({ 5, 0, 25, 10 });
+    CHECK_EQUAL(damage.size(), 1u);
+    CHECK(hasRect(damage, { 0, 0, 30, 10 }));
+}
+
+static void testMergeClosestPair()
+{
+    DamageTracker damage;
+    // the last two rects are the closest pair
+    for (int x = 0; x <= 600; x += 100)
+        damage.add({ x, 0, x + 1, 1 });
+    damage.add({ 650, 0, 651, 1 });
+    CHECK_EQUAL(damage.size(), DamageTracker::kMaxRects);
+
+    damage.add({ 2000, 0, 2001, 1 });
+    CHECK_EQUAL(damage.size(), DamageTracker::kMaxRects);
+    CHECK(hasRect(damage, { 600, 0, 651, 1 }));
+    CHECK(hasRect(damage, { 2000, 0, 2001, 1 }));
+    CHECK(hasRect(damage, { 0, 0, 1, 1 }));
+    CHECK_EQUAL(damage.bounds(), (DamageRect{ 0, 0, 2001, 1 }));
+
+    // nothing is lost however many rects are added
+    for (int i = 0; i < 100; ++i)
+        damage.add({ i * 37 % 1000, i * 53 % 1000, i * 37 % 1000 + 3, i * 53 % 1000 + 3 });
+    CHECK(damage.size() <= DamageTracker::kMaxRects);
+    for (int i = 0; i < 100; ++i)
+        CHECK(damage.intersects({ i * 37 % 1000, i * 53 % 1000, i * 37 % 1000 + 3, i * 53 % 1000 + 3 }));
+}
+
+static void testClip()
+{
+    DamageTracker damage;
+    damage.add({ -10, -10, 10, 10 });
+    damage.add({ 100, 100, 110, 110 });
+    damage.add({ 500, 500, 510, 510 });
+
+    damage.clip({ 0, 0, 200, 200 });
+    CHECK_EQUAL(damage.size(), 2u);
+    CHECK(hasRect(damage, { 0, 0, 10, 10 }));
+    CHECK(hasRect(damage, { 100, 100, 110, 110 }));
+
+    damage.clip({ 300, 300, 400, 400 });
+    CHECK(damage.empty());
+}
+
+static void testInfinite()
+{
+    DamageTracker damage;
+    damage.add({ 0, 0, 10, 10 });
+    damage.makeInfinite();
+    CHECK(damage.infinite());
+    CHECK(!damage.empty());
+    CHECK(damage.intersects({ 1000000, 1000000, 1000001, 1000001 }));
+    CHECK(!damage.intersects({}));
+
+    // adding to infinite damage changes nothing
+    damage.add({ 0, 0, 10, 10 });
+    CHECK_EQUAL(damage.size(), 0u);
+
+    damage.clip({ 0, 0, 50, 60 });
+    CHECK(!damage.infinite());
+    CHECK_EQUAL(damage.size(), 1u);
+    CHECK_EQUAL(damage.bounds(), (DamageRect{ 0, 0, 50, 60 }));
+
+    DamageTracker other;
+    other.makeInfinite();
+    damage.unite(other);
+    CHECK(damage.infinite());
+
+    damage.clear();
+    CHECK(damage.empty());
+}
+
+static void testUnite()
+{
+    DamageTracker a;
+    DamageTracker b;
+    a.add({ 0, 0, 10, 10 });
+    b.add({ 10, 0, 20, 10 });
+    b.add({ 100, 100, 110, 110 });
+
+    a.unite(b);
+    CHECK_EQUAL(a.size(), 2u);
+    CHECK(hasRect(a, { 0, 0, 20, 10 }));
+    CHECK(hasRect(a, { 100, 100, 110, 110 }));
+}
+
+int main()
+{
+    testRect();
+    testAdd();
+    testCoalesce();
+    testMergeClosestPair();
+    testClip();
+    testInfinite();
+    testUnite();
+    return test::finish("DamageTrackerTest");
+}
@@ -0,0 +1,173 @@
+#include "BenchmarkUtils.h"
+#include "utils/IniParser.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// settings of the shipped ini file, as Configure declares them
+struct Settings
+{
+    bool auto_start;
+    bool run_as_admin;
+    bool ignore_minimized;
+    char font_family[64];
+    float font_size;
+    float background_alpha;
+    bool single_layered_window;
+    bool cloak_hidden_views;
+    bool compact_mode;
+    int show_delay;
+    bool highlight_jump_target;
+    unsigned int switch_group_key;
+    bool enable_prev_group_hotkey;
+    unsigned int switch_window_key;
+    bool enable_prev_window_hotkey;
+    unsigned int switch_monitor_key;
+    bool enable_prev_monitor_hotkey;
+    IniHotkey keep_showing_hotkey;
+    bool enable_group_jump_hotkeys;
+};
+
+#define FIELD(section, key, type, member, default_value) \
+    { section, key, IniType::type, offsetof(Settings, member), sizeof(Settings::member), \
+            default_value, kIniNoMin, kIniNoMax, 0 }
+
+constexpr IniField kFields[] = {
+    FIELD("General", "bAutoStart", Bool, auto_start, "0"),
+    FIELD("General", "bRunAsAdmin", Bool, run_as_admin, "0"),
+    FIELD("Window Filter", "bIgnoreMinimized", Bool, ignore_minimized, "0"),
+    FIELD("UI", "sFontFamily", String, font_family, "Segoe UI"),
+    FIELD("UI", "fFontSize", Float, font_size, "8"),
+    FIELD("UI", "fBackgroundAlpha", Float, background_alpha, "0.8"),
+    FIELD("UI", "bSingleLayeredWindow", Bool, single_layered_window, "0"),
+    FIELD("UI", "bCloakHiddenViews", Bool, cloak_hidden_views, "0"),
+    FIELD("UI", "bCompactMode", Bool, compact_mode, "0"),
+    FIELD("UI", "iShowDelay", Int, show_delay, "0"),
+    FIELD("UI", "bHighlightJumpTarget", Bool, highlight_jump_target, "1"),
+    FIELD("Hotkeys", "kSwitchGroupkey", Key, switch_group_key, "F1"),
+    FIELD("Hotkeys", "bEnablePrevGroupHotkey", Bool, enable_prev_group_hotkey, "0"),
+    FIELD("Hotkeys", "kSwitchWindowkey", Key, switch_window_key, "F2"),
+    FIELD("Hotkeys", "bEnablePrevWindowHotkey", Bool, enable_prev_window_hotkey, "0"),
+    FIELD("Hotkeys", "kSwitchMonitorkey", Key, switch_monitor_key, "F3"),
+    FIELD("Hotkeys", "bEnablePrevMonitorHotkey", Bool, enable_prev_monitor_hotkey, "0"),
+    FIELD("Hotkeys", "hKeepShowingHotkey", Hotkey, keep_showing_hotkey, "0"),
+    FIELD("Hotkeys", "bEnableGroupJumpHotkeys", Bool, enable_group_jump_hotkeys, "0"),
+};
+
+#undef FIELD
+
+constexpr IniName kKeys[] = {
+    { "F1", 0x70 }, { "F2", 0x71 }, { "F3", 0x72 }, { "F4", 0x73 }, { "TAB", 0x09 }, { "`", 0xC0 }
+};
+constexpr IniName kModifiers[] = { { "ALT", 1 }, { "CTRL", 2 }, { "SHIFT", 4 } };
+
+constexpr IniSchema kSchema = {
+    kFields, sizeof(kFields) / sizeof(kFields[0]),
+    kKeys, sizeof(kKeys) / sizeof(kKeys[0]),
+    kModifiers, sizeof(kModifiers) / sizeof(kModifiers[0]),
+};
+
+// the parser replaced by IniParser: a stream read by lines, a regex per line and
+// settings found by name in a map of each section
+struct OldSettings
+{
+    std::unordered_map<std::string, bool> bools;
+    std::unordered_map<std::string, float> floats;
+    std::unordered_map<std::string, unsigned int> keys;
+    std::unordered_map<std::string, std::string> strings;
+};
+
+static void oldParse(const std::string &text, OldSettings *settings)
+{
+    static const std::unordered_map<std::string, int> section_tags = {
+        { "[General]", 1 }, { "[Window Filter]", 2 }, { "[UI]", 3 }, { "[Hotkeys]", 4 },
+    };
+    static const std::unordered_map<std::string, unsigned int> key_map = {
+        { "F1", 0x70 }, { "F2", 0x71 }, { "F3", 0x72 }, { "F4", 0x73 }, { "TAB", 0x09 }, { "`", 0xC0 }
+    };
+
+    std::istringstream file(text);
+    std::string buffer;
+    bool in_section = false;
+    while (std::getline(file, buffer)) {
+        if (buffer.empty() || buffer[0] == '#')
+            continue;
+        if (buffer[0] == '[') {
+            in_section = section_tags.find(buffer) != section_tags.end();
+            continue;
+        }
+        if (!in_section)
+            continue;
+
+        std::smatch match;
+        if (!std::regex_search(buffer, match, std::regex("\\s*^(.*)\\s*=\\s*(.*)\\s*$")))
+            continue;
+        const std::string key = match[1].str();
+        const std::string value = match[2].str();
+        if (key.empty() || value.empty())
+            continue;
+        switch (key[0]) {
+        case 'b':
+            settings->bools[key] = value[0] != '0';
+            break;
+        case 'f':
+            settings->floats[key] = std::stof(value);
+            break;
+        case 'k':
+            {
+                auto it = key_map.find(value);
+                if (it != key_map.end())
+                    settings->keys[key] = it->second;
+            }
+            break;
+        case 's':
+            settings->strings[key] = value;
+            break;
+        }
+    }
+}
+
+static std::string readFile(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = argc > 1 ? argv[1] : INI_FILE;
+    const std::string text = readFile(path);
+    if (text.empty()) {
+        std::printf("can not read %s\n", path);
+        return 1;
+    }
+
+    const IniParser parser(kSchema);
+    Settings settings;
+    const double new_time = bench::secondsPerCall([&]() {
+        parser.applyDefaults(&settings);
+        parser.parse(text.data(), text.size(), &settings, nullptr);
+        bench::consume(settings);
+    });
+
+    const double old_time = bench::secondsPerCall([&]() {
+        OldSettings old_settings;
+        oldParse(text, &old_settings);
+        bench::consume(old_settings);
+    });
+
+    std::printf("%zu bytes of %s\n", text.size(), path);
+    std::printf("%-10s %14s\n", "parser", "us/load");
+    std::printf("%-10s %14.2f\n", "regex", old_time * 1e6);
+    std::printf("%-10s %14.2f\n", "IniParser", new_time * 1e6);
+    std::printf("speedup %.1fx\n", old_time / new_time);
+    return 0;
+}
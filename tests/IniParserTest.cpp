@@ -0,0 +1,236 @@
+#include "TestUtils.h"
+#include "utils/IniParser.h"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+struct TestSettings
+{
+    bool enabled;
+    int count;
+    float ratio;
+    char name[8];
+    unsigned int key;
+    IniHotkey hotkey;
+};
+
+enum TestTag
+{
+    TagMain = 1,
+    TagKeys = 2
+};
+
+#define FIELD(section, key, type, member, default_value, min_value, max_value, tag) \
+    { section, key, IniType::type, offsetof(TestSettings, member), sizeof(TestSettings::member), \
+            default_value, min_value, max_value, tag }
+
+constexpr IniField kFields[] = {
+    FIELD("Main", "bEnabled", Bool, enabled, "1", kIniNoMin, kIniNoMax, TagMain),
+    FIELD("Main", "iCount", Int, count, "5", 0, 100, TagMain),
+    FIELD("Main", "fRatio", Float, ratio, "0.5", 0.01, 1, TagMain),
+    FIELD("Main", "sName", String, name, "box", kIniNoMin, kIniNoMax, TagMain),
+    FIELD("Key Settings", "kKey", Key, key, "F1", kIniNoMin, kIniNoMax, TagKeys),
+    FIELD("Key Settings", "hHotkey", Hotkey, hotkey, "0", kIniNoMin, kIniNoMax, TagKeys),
+};
+
+#undef FIELD
+
+static_assert(validIniSchema(kFields, sizeof(kFields) / sizeof(kFields[0]), sizeof(TestSettings)),
+        "type and size of a field do not match");
+
+constexpr IniName kKeys[] = { { "F1", 0x70 }, { "TAB", 0x09 }, { "`", 0xC0 } };
+constexpr IniName kModifiers[] = { { "ALT", 1 }, { "CTRL", 2 }, { "SHIFT", 4 } };
+
+constexpr IniSchema kSchema = {
+    kFields, sizeof(kFields) / sizeof(kFields[0]),
+    kKeys, sizeof(kKeys) / sizeof(kKeys[0]),
+    kModifiers, sizeof(kModifiers) / sizeof(kModifiers[0]),
+};
+
+static TestSettings parse(const std::string &text, std::vector<IniDiagnostic> *diagnostics = nullptr)
+{
+    const IniParser parser(kSchema);
+    TestSettings settings;
+    parser.applyDefaults(&settings);
+    parser.parse(text.data(), text.size(), &settings, diagnostics);
+    return settings;
+}
+
+static bool hasDiagnostic(const std::vector<IniDiagnostic> &diagnostics, size_t line,
+        const std::string &message)
+{
+    for (const IniDiagnostic &diagnostic : diagnostics) {
+        if (diagnostic.line == line && diagnostic.message == message)
+            return true;
+    }
+    return false;
+}
+
+static void testDefaults()
+{
+    const TestSettings settings = parse("");
+    CHECK(settings.enabled);
+    CHECK_EQUAL(settings.count, 5);
+    CHECK_EQUAL(settings.ratio, 0.5f);
+    CHECK_EQUAL(std::string(settings.name), "box");
+    CHECK_EQUAL(settings.key, 0x70u);
+    CHECK(settings.hotkey == IniHotkey(0, 0));
+}
+
+static void testSections()
+{
+    std::vector<IniDiagnostic> diagnostics;
+    const TestSettings settings = parse(
+            "[Main]\n"
+            "iCount=7\n"
+            "[Key Settings]\n"
+            "kKey=TAB\n"
+            // same key name, but in another section
+            "iCount=9\n"
+            "[Main]\n"
+            "bEnabled=0\n", &diagnostics);
+    CHECK(!settings.enabled);
+    CHECK_EQUAL(settings.count, 7);
+    CHECK_EQUAL(settings.key, 0x09u);
+    CHECK_EQUAL(diagnostics.size(), 1u);
+    CHECK(hasDiagnostic(diagnostics, 5, "unknown key: iCount"));
+}
+
+static void testWhitespaceAndComments()
+{
+    std::vector<IniDiagnostic> diagnostics;
+    const TestSettings settings = parse(
+            "\xEF\xBB\xBF# comment\r\n"
+            "\r\n"
+            "  [ Main ]  \r\n"
+            "; another comment\r\n"
+            "\t iCount \t=\t 12 \r\n"
+            "sName =  a b  \r\n"
+            "fRatio=\r\n"
+            "[Key Settings]\n"
+            "hHotkey = ctrl + Alt + f1", &diagnostics);
+    CHECK(diagnostics.empty());
+    CHECK_EQUAL(settings.count, 12);
+    // inner spaces are kept
+    CHECK_EQUAL(std::string(settings.name), "a b");
+    // empty values keep the current value
+    CHECK_EQUAL(settings.ratio, 0.5f);
+    CHECK(settings.hotkey == IniHotkey(3, 0x70));
+}
+
+static void testBadValues()
+{
+    std::vector<IniDiagnostic> diagnostics;
+    const TestSettings settings = parse(
+            "[Main]\n"
+            "bEnabled=yes\n"
+            "iCount=12x\n"
+            "fRatio=.\n"
+            "sName=too long name\n"
+            "[Key Settings]\n"
+            "kKey=NOPE\n"
+            "hHotkey=F1\n"
+            "hHotkey=ALT+ALT+ALT+ALT+F1\n"
+            "hHotkey=WIN+F1\n", &diagnostics);
+    // bad values keep the current value
+    CHECK(settings.enabled);
+    CHECK_EQUAL(settings.count, 5);
+    CHECK_EQUAL(settings.ratio, 0.5f);
+    CHECK_EQUAL(std::string(settings.name), "box");
+    CHECK_EQUAL(settings.key, 0x70u);
+    CHECK(settings.hotkey == IniHotkey(0, 0));
+
+    CHECK_EQUAL(diagnostics.size(), 8u);
+    CHECK(hasDiagnostic(diagnostics, 2, "expected 0 or 1: yes"));
+    CHECK(hasDiagnostic(diagnostics, 3, "expected an integer: 12x"));
+    CHECK(hasDiagnostic(diagnostics, 4, "expected a number: ."));
+    CHECK(hasDiagnostic(diagnostics, 5, "string too long: too long name"));
+    CHECK(hasDiagnostic(diagnostics, 7, "unknown key name: NOPE"));
+    // a hotkey needs a modifier, at most three of them
+    CHECK(hasDiagnostic(diagnostics, 8, "expected MODIFIER+KEY: F1"));
+    CHECK(hasDiagnostic(diagnostics, 9, "expected MODIFIER+KEY: ALT+ALT+ALT+ALT+F1"));
+    CHECK(hasDiagnostic(diagnostics, 10, "expected MODIFIER+KEY: WIN+F1"));
+}
+
+static void testClamp()
+{
+    std::vector<IniDiagnostic> diagnostics;
+    const TestSettings settings = parse(
+            "[Main]\n"
+            "iCount=-3\n"
+            "fRatio=2.5\n", &diagnostics);
+    CHECK_EQUAL(settings.count, 0);
+    CHECK_EQUAL(settings.ratio, 1.f);
+    CHECK(hasDiagnostic(diagnostics, 2, "value out of range, clamped: -3"));
+    CHECK(hasDiagnostic(diagnostics, 3, "value out of range, clamped: 2.5"));
+
+    // saturated before it is clamped
+    CHECK_EQUAL(parse("[Main]\niCount=99999999999999999999\n").count, 100);
+}
+
+static void testKeys()
+{
+    CHECK_EQUAL(parse("[Key Settings]\nkKey=q\n").key, static_cast<unsigned int>('Q'));
+    CHECK_EQUAL(parse("[Key Settings]\nkKey=7\n").key, static_cast<unsigned int>('7'));
+    CHECK_EQUAL(parse("[Key Settings]\nkKey=tab\n").key, 0x09u);
+    CHECK_EQUAL(parse("[Key Settings]\nkKey=`\n").key, 0xC0u);
+    // 0 means none
+    CHECK_EQUAL(parse("[Key Settings]\nkKey=0\n").key, 0u);
+    CHECK(parse("[Key Settings]\nhHotkey=SHIFT+ALT+`\n").hotkey == IniHotkey(5, 0xC0));
+}
+
+static void testUnknown()
+{
+    std::vector<IniDiagnostic> diagnostics;
+    const TestSettings settings = parse(
+            "iCount=1\n"
+            "[Other]\n"
+            "iCount=2\n"
+            "[Main\n"
+            "iCount=3\n"
+            "[Main]\n"
+            "iUnknown=4\n"
+            "no value here\n"
+            "iCount=5\n", &diagnostics);
+    CHECK_EQUAL(settings.count, 5);
+    CHECK_EQUAL(diagnostics.size(), 6u);
+    CHECK(hasDiagnostic(diagnostics, 1, "key outside of a section: iCount"));
+    // keys of an unknown section are reported once with the section
+    CHECK(hasDiagnostic(diagnostics, 2, "unknown section: Other"));
+    CHECK(hasDiagnostic(diagnostics, 4, "unclosed section: [Main"));
+    CHECK(hasDiagnostic(diagnostics, 5, "key outside of a section: iCount"));
+    CHECK(hasDiagnostic(diagnostics, 7, "unknown key: iUnknown"));
+    CHECK(hasDiagnostic(diagnostics, 8, "expected key=value: no value here"));
+}
+
+static void testChangedTags()
+{
+    const IniParser parser(kSchema);
+    const TestSettings a = parse("");
+    TestSettings b = a;
+    CHECK_EQUAL(parser.changedTags(&a, &b), 0u);
+
+    b = parse("[Key Settings]\nhHotkey=ALT+F1\n");
+    CHECK_EQUAL(parser.changedTags(&a, &b), static_cast<unsigned int>(TagKeys));
+    b = parse("[Main]\nfRatio=0.25\n[Key Settings]\nkKey=TAB\n");
+    CHECK_EQUAL(parser.changedTags(&a, &b), static_cast<unsigned int>(TagMain | TagKeys));
+
+    // bytes after the terminator of a shorter string are not compared
+    TestSettings c = parse("[Main]\nsName=longer\n");
+    parser.parse("[Main]\nsName=box\n", std::strlen("[Main]\nsName=box\n"), &c, nullptr);
+    CHECK_EQUAL(parser.changedTags(&a, &c), 0u);
+}
+
+int main()
+{
+    testDefaults();
+    testSections();
+    testWhitespaceAndComments();
+    testBadValues();
+    testClamp();
+    testKeys();
+    testUnknown();
+    testChangedTags();
+    return test::finish("IniParserTest");
+}
@@ -0,0 +1,128 @@
+#include "TestUtils.h"
+#include "utils/LatencyHistogram.h"
+
+#include <thread>
+#include <vector>
+
+static void testBucketBoundaries()
+{
+    using H = LatencyHistogram;
+    // exact below two sub-bucket ranges
+    for (uint64_t value = 0; value < 2 * H::kSubBucketCount; ++value) {
+        CHECK_EQUAL(H::bucketIndex(value), static_cast<int>(value));
+        CHECK_EQUAL(H::bucketLowerBound(static_cast<int>(value)), value);
+        CHECK_EQUAL(H::bucketUpperBound(static_cast<int>(value)), value);
+    }
+
+    // 64 and 65 share a bucket of width 2
+    CHECK_EQUAL(H::bucketIndex(64), 64);
+    CHECK_EQUAL(H::bucketIndex(65), 64);
+    CHECK_EQUAL(H::bucketIndex(66), 65);
+    CHECK_EQUAL(H::bucketLowerBound(64), 64u);
+    CHECK_EQUAL(H::bucketUpperBound(64), 65u);
+
+    // every bucket is contiguous with the next and contains its bounds
+    for (int i = 0; i + 1 < H::kBucketCount; ++i) {
+        const uint64_t lower = H::bucketLowerBound(i);
+        const uint64_t upper = H::bucketUpperBound(i);
+        CHECK(lower <= upper);
+        CHECK_EQUAL(H::bucketLowerBound(i + 1), upper + 1);
+        CHECK_EQUAL(H::bucketIndex(lower), i);
+        CHECK_EQUAL(H::bucketIndex(upper), i);
+    }
+
+    // about 3% precision
+    for (int i = 2 * H::kSubBucketCount; i < H::kBucketCount; ++i) {
+        const double width = static_cast<double>(H::bucketUpperBound(i) - H::bucketLowerBound(i) + 1);
+        CHECK(width / H::bucketLowerBound(i) <= 1.0 / H::kSubBucketCount);
+    }
+
+    // values past the range fall into the last bucket
+    const uint64_t last_value = H::bucketUpperBound(H::kBucketCount - 1);
+    CHECK_EQUAL(last_value, (1ull << H::kMaxValueBits) - 1);
+    CHECK_EQUAL(H::bucketIndex(last_value), H::kBucketCount - 1);
+    CHECK_EQUAL(H::bucketIndex(last_value + 1), H::kBucketCount - 1);
+    CHECK_EQUAL(H::bucketIndex(UINT64_MAX), H::kBucketCount - 1);
+}
+
+static void testEmpty()
+{
+    LatencyHistogram histogram;
+    CHECK_EQUAL(histogram.count(), 0u);
+    CHECK_EQUAL(histogram.minValue(), 0u);
+    CHECK_EQUAL(histogram.maxValue(), 0u);
+    CHECK_EQUAL(histogram.mean(), 0.0);
+    CHECK_EQUAL(histogram.percentile(0), 0u);
+    CHECK_EQUAL(histogram.percentile(50), 0u);
+    CHECK_EQUAL(histogram.percentile(100), 0u);
+}
+
+static void testPercentiles()
+{
+    LatencyHistogram histogram;
+    // 1..100 are exact up to 63, in buckets of 2 above
+    for (uint64_t value = 1; value <= 100; ++value)
+        histogram.record(value);
+    CHECK_EQUAL(histogram.count(), 100u);
+    CHECK_EQUAL(histogram.minValue(), 1u);
+    CHECK_EQUAL(histogram.maxValue(), 100u);
+    CHECK_EQUAL(histogram.mean(), 50.5);
+
+    // percentile 0 is the first sample
+    CHECK_EQUAL(histogram.percentile(0), 1u);
+    CHECK_EQUAL(histogram.percentile(50), 50u);
+    // upper bound of the bucket of 98 and 99
+    CHECK_EQUAL(histogram.percentile(99), 99u);
+    // clamped to the largest sample, not the bucket bound
+    CHECK_EQUAL(histogram.percentile(100), 100u);
+    CHECK_EQUAL(histogram.percentile(150), 100u);
+
+    // a single slow sample decides p100 only
+    LatencyHistogram tail;
+    for (int i = 0; i < 999; ++i)
+        tail.record(1000);
+    tail.record(5000000);
+    CHECK(tail.percentile(50) >= 1000 && tail.percentile(50) <= 1031);
+    CHECK(tail.percentile(99) >= 1000 && tail.percentile(99) <= 1031);
+    CHECK_EQUAL(tail.percentile(100), 5000000u);
+
+    tail.reset();
+    CHECK_EQUAL(tail.count(), 0u);
+    CHECK_EQUAL(tail.percentile(99), 0u);
+    CHECK_EQUAL(tail.maxValue(), 0u);
+}
+
+static void testConcurrentRecord()
+{
+    // hook, message and render threads record into the same histograms
+    const int thread_count = 4;
+    const uint64_t per_thread = 100000;
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&histogram, t, per_thread]() {
+            for (uint64_t i = 1; i <= per_thread; ++i)
+                histogram.record(i + t);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    // no sample is lost and min, max and sum are exact
+    CHECK_EQUAL(histogram.count(), thread_count * per_thread);
+    CHECK_EQUAL(histogram.minValue(), 1u);
+    CHECK_EQUAL(histogram.maxValue(), per_thread + thread_count - 1);
+    const double expected_mean = (per_thread + 1) / 2.0 + (thread_count - 1) / 2.0;
+    CHECK_EQUAL(histogram.mean(), expected_mean);
+    CHECK_EQUAL(histogram.percentile(0), 1u);
+    CHECK_EQUAL(histogram.percentile(100), per_thread + thread_count - 1);
+}
+
+int main()
+{
+    testBucketBoundaries();
+    testEmpty();
+    testPercentiles();
+    testConcurrentRecord();
+    return test::finish("LatencyHistogramTest");
+}
@@ -0,0 +1,116 @@
+#include "TestUtils.h"
+#include "utils/LruCache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using Cache = LruCache<int, std::string>;
+
+// keys from the most recently used
+static std::vector<int> keys(Cache &cache)
+{
+    std::vector<int> result;
+    cache.forEach([&result](int key, const std::string &) { result.push_back(key); });
+    return result;
+}
+
+static void testEvictionOrder()
+{
+    Cache cache(3);
+    CHECK_EQUAL(cache.capacity(), 3u);
+    cache.put(1, "a");
+    cache.put(2, "b");
+    cache.put(3, "c");
+    CHECK_EQUAL(keys(cache), (std::vector<int>{ 3, 2, 1 }));
+
+    // the least recently put is dropped first
+    cache.put(4, "d");
+    CHECK_EQUAL(cache.size(), 3u);
+    CHECK(!cache.contains(1));
+    CHECK_EQUAL(keys(cache), (std::vector<int>{ 4, 3, 2 }));
+
+    // putting an existing key replaces its value and makes it the most recent
+    cache.put(2, "B");
+    CHECK_EQUAL(cache.size(), 3u);
+    CHECK_EQUAL(keys(cache), (std::vector<int>{ 2, 4, 3 }));
+    cache.put(5, "e");
+    CHECK(!cache.contains(3));
+    CHECK_EQUAL(*cache.get(2), "B");
+}
+
+static void testGetTouches()
+{
+    Cache cache(3);
+    cache.put(1, "a");
+    cache.put(2, "b");
+    cache.put(3, "c");
+
+    CHECK_EQUAL(*cache.get(1), "a");
+    CHECK_EQUAL(keys(cache), (std::vector<int>{ 1, 3, 2 }));
+    // 2 is the least recently used now
+    cache.put(4, "d");
+    CHECK(cache.contains(1));
+    CHECK(!cache.contains(2));
+
+    CHECK(cache.get(2) == nullptr);
+    // contains does not touch
+    CHECK(cache.contains(3));
+    cache.put(5, "e");
+    CHECK(!cache.contains(3));
+
+    // values are changed in place
+    *cache.get(4) = "D";
+    CHECK_EQUAL(*cache.get(4), "D");
+}
+
+static void testEraseAndTake()
+{
+    Cache cache(3);
+    cache.put(1, "a");
+    cache.put(2, "b");
+    cache.put(3, "c");
+
+    cache.erase(2);
+    cache.erase(7);
+    CHECK_EQUAL(keys(cache), (std::vector<int>{ 3, 1 }));
+
+    std::string value;
+    CHECK(cache.take(1, &value));
+    CHECK_EQUAL(value, "a");
+    CHECK(!cache.take(1, &value));
+    CHECK_EQUAL(keys(cache), (std::vector<int>{ 3 }));
+
+    // freed slots are used before anything is evicted
+    cache.put(4, "d");
+    cache.put(5, "e");
+    CHECK_EQUAL(keys(cache), (std::vector<int>{ 5, 4, 3 }));
+
+    cache.clear();
+    CHECK_EQUAL(cache.size(), 0u);
+    CHECK(cache.get(5) == nullptr);
+}
+
+static void testMoveOnlyValues()
+{
+    // cached list surfaces are move only
+    LruCache<int, std::unique_ptr<int>> cache(2);
+    cache.put(1, std::make_unique<int>(10));
+    cache.put(2, std::make_unique<int>(20));
+    std::unique_ptr<int> value;
+    CHECK(cache.take(1, &value));
+    CHECK(value && *value == 10);
+    cache.put(3, std::make_unique<int>(30));
+    cache.put(4, std::make_unique<int>(40));
+    CHECK(!cache.contains(2));
+    CHECK_EQUAL(**cache.get(4), 40);
+}
+
+int main()
+{
+    testEvictionOrder();
+    testGetTouches();
+    testEraseAndTake();
+    testMoveOnlyValues();
+    return test::finish("LruCacheTest");
+}
@@ -0,0 +1,203 @@
+#include "TestUtils.h"
+#include "utils/MruList.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// an enumerated window, group is its program
+struct Window
+{
+    int hwnd;
+    std::string group;
+};
+
+// windows of the desktop, the enumeration is replayed on every update as GlobalData does
+class Desktop
+{
+public:
+    explicit Desktop(std::vector<Window> windows) : m_windows(std::move(windows)) {}
+
+    void activate(int hwnd) { m_mru.touch(hwnd); }
+    void close(int hwnd)
+    {
+        m_windows.erase(std::remove_if(m_windows.begin(), m_windows.end(),
+                [hwnd](const Window &window) { return window.hwnd == hwnd; }), m_windows.end());
+        m_closed.insert(hwnd);
+    }
+    // still open, but not enumerated, e.g. on another virtual desktop
+    void hide(int hwnd) { close(hwnd); m_closed.erase(hwnd); }
+
+    std::vector<Window> update()
+    {
+        std::vector<Window> windows = m_windows;
+        m_mru.order(&windows, [](const Window &window) { return window.hwnd; },
+                [this](int hwnd) { return m_closed.count(hwnd) != 0; });
+        return windows;
+    }
+
+    const MruList<int> &mru() const { return m_mru; }
+
+private:
+    std::vector<Window> m_windows;  // in enumeration order
+    std::set<int> m_closed;
+    MruList<int> m_mru;
+};
+
+static std::vector<int> hwnds(const std::vector<Window> &windows)
+{
+    std::vector<int> result;
+    for (const Window &window : windows)
+        result.push_back(window.hwnd);
+    return result;
+}
+
+// groups are ordered by their most recent window, as GlobalData::update builds them
+static std::vector<std::string> groups(const std::vector<Window> &windows)
+{
+    std::vector<std::string> result;
+    for (const Window &window : windows) {
+        if (std::find(result.begin(), result.end(), window.group) == result.end())
+            result.push_back(window.group);
+    }
+    return result;
+}
+
+static Desktop testDesktop()
+{
+    return Desktop({ { 1, "a" }, { 2, "b" }, { 3, "a" }, { 4, "c" }, { 5, "b" } });
+}
+
+static void testTouch()
+{
+    MruList<int> mru;
+    CHECK(mru.empty());
+    mru.touch(1);
+    mru.touch(2);
+    mru.touch(1);
+    CHECK_EQUAL(mru.size(), 2u);
+    CHECK_EQUAL(std::vector<int>(mru.begin(), mru.end()), (std::vector<int>{ 1, 2 }));
+
+    mru.erase(1);
+    mru.erase(7);
+    CHECK(!mru.contains(1));
+    CHECK_EQUAL(std::vector<int>(mru.begin(), mru.end()), (std::vector<int>{ 2 }));
+    mru.clear();
+    CHECK(mru.empty());
+}
+
+static void testEnumerationOrder()
+{
+    // nothing used yet, enumeration order is kept
+    Desktop desktop = testDesktop();
+    CHECK_EQUAL(hwnds(desktop.update()), (std::vector<int>{ 1, 2, 3, 4, 5 }));
+}
+
+static void testPromote()
+{
+    Desktop desktop = testDesktop();
+    desktop.activate(4);
+    desktop.activate(2);
+    CHECK_EQUAL(hwnds(desktop.update()), (std::vector<int>{ 2, 4, 1, 3, 5 }));
+
+    // used again, moves to the front
+    desktop.activate(4);
+    CHECK_EQUAL(hwnds(desktop.update()), (std::vector<int>{ 4, 2, 1, 3, 5 }));
+}
+
+static void testClose()
+{
+    Desktop desktop = testDesktop();
+    desktop.activate(1);
+    desktop.activate(3);
+    desktop.activate(5);
+
+    desktop.close(3);
+    CHECK_EQUAL(hwnds(desktop.update()), (std::vector<int>{ 5, 1, 2, 4 }));
+    CHECK(!desktop.mru().contains(3));
+
+    // hidden windows keep their place for when they come back
+    desktop.hide(5);
+    CHECK_EQUAL(hwnds(desktop.update()), (std::vector<int>{ 1, 2, 4 }));
+    CHECK(desktop.mru().contains(5));
+
+    // a window activated and closed before the next update is dropped too
+    desktop.activate(2);
+    desktop.close(2);
+    CHECK_EQUAL(hwnds(desktop.update()), (std::vector<int>{ 1, 4 }));
+    CHECK(!desktop.mru().contains(2));
+}
+
+static void testGroupOrder()
+{
+    Desktop desktop = testDesktop();
+    CHECK_EQUAL(groups(desktop.update()), (std::vector<std::string>{ "a", "b", "c" }));
+
+    // any window of a group brings the group forward
+    desktop.activate(4);
+    CHECK_EQUAL(groups(desktop.update()), (std::vector<std::string>{ "c", "a", "b" }));
+    desktop.activate(5);
+    CHECK_EQUAL(groups(desktop.update()), (std::vector<std::string>{ "b", "c", "a" }));
+
+    // the group follows its next recent window once the most recent one is closed
+    desktop.activate(3);
+    desktop.activate(2);
+    desktop.close(2);
+    CHECK_EQUAL(groups(desktop.update()), (std::vector<std::string>{ "a", "b", "c" }));
+    CHECK_EQUAL(hwnds(desktop.update()), (std::vector<int>{ 3, 5, 4, 1 }));
+
+    // closing every window of a group removes it
+    desktop.close(4);
+    CHECK_EQUAL(groups(desktop.update()), (std::vector<std::string>{ "a", "b" }));
+}
+
+// random activation and close streams against a plain vector model of recent use
+static void testEventStream()
+{
+    std::mt19937 random(7);
+    for (int round = 0; round < 50; ++round) {
+        std::vector<Window> windows;
+        for (int i = 0; i < 20; ++i)
+            windows.push_back({ i, std::string(1, static_cast<char>('a' + random() % 5)) });
+        Desktop desktop(windows);
+        std::vector<int> recent;  // most recent first
+
+        for (int event = 0; event < 60; ++event) {
+            const int hwnd = static_cast<int>(random() % 20);
+            const auto found = std::find_if(windows.begin(), windows.end(),
+                    [hwnd](const Window &window) { return window.hwnd == hwnd; });
+            if (found == windows.end())
+                continue;
+
+            recent.erase(std::remove(recent.begin(), recent.end(), hwnd), recent.end());
+            if (random() % 4 == 0) {
+                desktop.close(hwnd);
+                windows.erase(found);
+            } else {
+                desktop.activate(hwnd);
+                recent.insert(recent.begin(), hwnd);
+            }
+
+            std::vector<int> expected = recent;
+            for (const Window &window : windows) {
+                if (std::find(recent.begin(), recent.end(), window.hwnd) == recent.end())
+                    expected.push_back(window.hwnd);
+            }
+            CHECK_EQUAL(hwnds(desktop.update()), expected);
+        }
+        CHECK_EQUAL(std::vector<int>(desktop.mru().begin(), desktop.mru().end()), recent);
+    }
+}
+
+int main()
+{
+    testTouch();
+    testEnumerationOrder();
+    testPromote();
+    testClose();
+    testGroupOrder();
+    testEventStream();
+    return test::finish("MruListTest");
+}
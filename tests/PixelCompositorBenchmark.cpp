@@ -0,0 +1,62 @@
+#include "BenchmarkUtils.h"
+#include "utils/PixelCompositor.h"
+
+#include <cstdio>
+#include <vector>
+
+using KernelSet = PixelCompositor::KernelSet;
+
+static const char *kernelSetName(KernelSet set)
+{
+    switch (set) {
+    case KernelSet::AVX2:
+        return "avx2";
+    case KernelSet::SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+int main()
+{
+    // a full view surface, and a thumbnail sized rect whose width leaves tail pixels
+    struct Size { int width; int height; };
+    const Size sizes[] = { { 1920, 1080 }, { 237, 133 } };
+
+    std::printf("%-8s %-10s %12s %12s %12s\n", "kernels", "size", "fill MP/s", "blend MP/s",
+            "stroke MP/s");
+    for (KernelSet set : { KernelSet::Scalar, KernelSet::SSE2, KernelSet::AVX2 }) {
+        if (!PixelCompositor::setKernelSet(set))
+            continue;
+
+        for (const Size &size : sizes) {
+            std::vector<uint32_t> pixels(static_cast<size_t>(size.width) * size.height, 0xFF202020);
+            const PixelSurface surface = { pixels.data(), size.width, size.height, size.width };
+            const double megapixels = size.width * size.height / 1e6;
+
+            const double fill_time = bench::secondsPerCall([&]() {
+                PixelCompositor::fill(surface, 0, 0, size.width, size.height, 0xFF202020);
+                bench::consume(pixels);
+            });
+            // translucent hover color, the blend kernel is not skipped
+            const double blend_time = bench::secondsPerCall([&]() {
+                PixelCompositor::blend(surface, 0, 0, size.width, size.height, 0x40202020);
+                bench::consume(pixels);
+            });
+            // select frame of 3 pixels, mostly short rows at the sides
+            const int frame_pixels = 3 * 2 * size.width + 3 * 2 * (size.height - 6);
+            const double stroke_time = bench::secondsPerCall([&]() {
+                PixelCompositor::stroke(surface, 0, 0, size.width, size.height, 3, 0x80404040);
+                bench::consume(pixels);
+            });
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "%dx%d", size.width, size.height);
+            std::printf("%-8s %-10s %12.0f %12.0f %12.0f\n", kernelSetName(set), name,
+                    megapixels / fill_time, megapixels / blend_time,
+                    frame_pixels / 1e6 / stroke_time);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "TestUtils.h"
+#include "utils/PixelCompositor.h"
+
+#include <random>
+#include <vector>
+
+using KernelSet = PixelCompositor::KernelSet;
+
+static const KernelSet kVectorSets[] = { KernelSet::SSE2, KernelSet::AVX2 };
+
+// random pixels with a border of guard pixels, stride is wider than the surface
+struct TestSurface
+{
+    static constexpr int kGuard = 3;
+
+    TestSurface(int width, int height, std::mt19937 *random)
+        : pixels((height + kGuard * 2) * (width + kGuard * 2)), width(width), height(height)
+    {
+        std::uniform_int_distribution<uint32_t> pixel;
+        for (uint32_t &value : pixels)
+            value = PixelCompositor::premultiply(pixel(*random));
+    }
+
+    int stride() const { return width + kGuard * 2; }
+    PixelSurface surface() { return { pixels.data() + kGuard * stride() + kGuard, width, height, stride() }; }
+
+    std::vector<uint32_t> pixels;
+    int width;
+    int height;
+};
+
+// exact source over of premultiplied pixels, without the rounding trick of the kernels
+static uint32_t referenceBlend(uint32_t dst, uint32_t color)
+{
+    const uint32_t inv_alpha = 255 - (color >> 24);
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t scaled = (((dst >> shift) & 0xFF) * inv_alpha * 2 + 255) / 510;
+        uint32_t channel = ((color >> shift) & 0xFF) + scaled;
+        if (channel > 0xFF)
+            channel = 0xFF;
+        result |= channel << shift;
+    }
+    return result;
+}
+
+// apply the same operation with set and with the scalar kernels, all pixels must match
+template<typename Operation>
+static bool sameAsScalar(KernelSet set, const TestSurface &source, Operation operation)
+{
+    TestSurface scalar = source;
+    TestSurface vector = source;
+
+    PixelCompositor::setKernelSet(KernelSet::Scalar);
+    operation(scalar.surface());
+    PixelCompositor::setKernelSet(set);
+    operation(vector.surface());
+    return scalar.pixels == vector.pixels;
+}
+
+static void testPremultiply()
+{
+    CHECK_EQUAL(PixelCompositor::premultiply(0xFF123456), 0xFF123456u);
+    CHECK_EQUAL(PixelCompositor::premultiply(0x00FFFFFF), 0x00000000u);
+    CHECK_EQUAL(PixelCompositor::premultiply(0x80FF0000), 0x80800000u);
+}
+
+static void testScalarBlend()
+{
+    PixelCompositor::setKernelSet(KernelSet::Scalar);
+    std::mt19937 random(1);
+    std::uniform_int_distribution<uint32_t> pixel;
+    int mismatches = 0;
+    for (int i = 0; i < 10000; ++i) {
+        const uint32_t dst = PixelCompositor::premultiply(pixel(random));
+        const uint32_t color = PixelCompositor::premultiply(pixel(random));
+        uint32_t value = dst;
+        PixelCompositor::blend({ &value, 1, 1, 1 }, 0, 0, 1, 1, color);
+        // transparent colors are skipped
+        mismatches += value != ((color >> 24) == 0 ? dst : referenceBlend(dst, color));
+    }
+    CHECK_EQUAL(mismatches, 0);
+}
+
+static void testClip()
+{
+    PixelCompositor::setKernelSet(KernelSet::Scalar);
+    std::mt19937 random(2);
+    TestSurface test(8, 8, &random);
+    const std::vector<uint32_t> before = test.pixels;
+
+    // guard pixels around the surface are kept
+    PixelCompositor::fill(test.surface(), -5, -5, 100, 100, 0xFF000000);
+    for (int y = 0; y < 8 + TestSurface::kGuard * 2; ++y) {
+        for (int x = 0; x < test.stride(); ++x) {
+            const size_t i = y * test.stride() + x;
+            const bool inside = x >= TestSurface::kGuard && x < 8 + TestSurface::kGuard
+                    && y >= TestSurface::kGuard && y < 8 + TestSurface::kGuard;
+            CHECK_EQUAL(test.pixels[i], inside ? 0xFF000000 : before[i]);
+        }
+    }
+
+    // empty and transparent operations change nothing
+    const std::vector<uint32_t> filled = test.pixels;
+    PixelCompositor::fill(test.surface(), 4, 4, 4, 8, 0xFFFFFFFF);
+    PixelCompositor::blend(test.surface(), 0, 0, 8, 8, 0x00000000);
+    PixelCompositor::stroke(test.surface(), 0, 0, 8, 8, 0, 0xFFFFFFFF);
+    CHECK(test.pixels == filled);
+}
+
+// widths around the vector sizes leave 0 to 7 tail pixels, left offsets make rows unaligned
+static void testKernelsMatchScalar()
+{
+    std::mt19937 random(3);
+    std::uniform_int_distribution<uint32_t> pixel;
+    for (KernelSet set : kVectorSets) {
+        if (!PixelCompositor::supported(set))
+            continue;
+
+        for (int width = 1; width <= 35; ++width) {
+            for (int left = 0; left < 4; ++left) {
+                const TestSurface source(width + left, 3, &random);
+                const uint32_t colors[] = {
+                    PixelCompositor::premultiply(pixel(random)),
+                    PixelCompositor::premultiply(pixel(random) | 0xFF000000),
+                    PixelCompositor::premultiply((pixel(random) & 0x00FFFFFF) | 0x01000000),
+                    0xFEFFFFFF,
+                };
+                for (uint32_t color : colors) {
+                    const int right = left + width;
+                    CHECK(sameAsScalar(set, source, [=](const PixelSurface &surface) {
+                        PixelCompositor::fill(surface, left, 0, right, 3, color);
+                    }));
+                    CHECK(sameAsScalar(set, source, [=](const PixelSurface &surface) {
+                        PixelCompositor::blend(surface, left, 0, right, 3, color);
+                    }));
+                    CHECK(sameAsScalar(set, source, [=](const PixelSurface &surface) {
+                        PixelCompositor::stroke(surface, left, 0, right, 3, 1, color);
+                    }));
+                }
+            }
+        }
+    }
+    PixelCompositor::setKernelSet(KernelSet::Scalar);
+}
+
+int main()
+{
+    testPremultiply();
+    testScalarBlend();
+    testClip();
+    testKernelsMatchScalar();
+    return test::finish("PixelCompositorTest");
+}
@@ -0,0 +1,80 @@
+#include "utils/SpscRing.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+// same size as a hotkey event of the keyboard hook
+struct Event
+{
+    int id;
+    uint64_t time;
+};
+
+struct Result
+{
+    double seconds;
+    long long full;  // pushes that found the ring full
+    long long wakes;
+};
+
+// producer pushes count events as fast as it can, the other side yields while the ring
+// is full or empty so the benchmark also runs on a single core
+template<size_t Capacity>
+static Result run(long long count)
+{
+    SpscRing<Event, Capacity> ring;
+    Result result = { 0, 0, 0 };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&ring, count]() {
+        Event event;
+        uint64_t sum = 0;
+        for (long long received = 0; received < count;) {
+            if (ring.pop(&event)) {
+                sum += event.time;
+                ++received;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        static volatile uint64_t sink;
+        sink = sum;
+        (void)sink;
+    });
+
+    for (long long i = 0; i < count; ++i) {
+        bool was_empty = false;
+        const Event event = { static_cast<int>(i), static_cast<uint64_t>(i) };
+        while (!ring.push(event, &was_empty)) {
+            ++result.full;
+            std::this_thread::yield();
+        }
+        result.wakes += was_empty;
+    }
+    consumer.join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+template<size_t Capacity>
+static void report(long long count)
+{
+    const Result result = run<Capacity>(count);
+    std::printf("%-10zu %14.1f %14.1f %14.4f %14.4f\n", Capacity, count / result.seconds / 1e6,
+            result.seconds * 1e9 / count, static_cast<double>(result.full) / count,
+            static_cast<double>(result.wakes) / count);
+}
+
+int main()
+{
+    constexpr long long kCount = 2000000;
+    std::printf("%-10s %14s %14s %14s %14s\n", "capacity", "M events/s", "ns/event",
+            "full/event", "wakes/event");
+    report<8>(kCount);
+    report<64>(kCount);
+    report<1024>(kCount);
+    return 0;
+}
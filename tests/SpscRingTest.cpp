@@ -0,0 +1,121 @@
+#include "TestUtils.h"
+#include "utils/SpscRing.h"
+
+#include <atomic>
+#include <thread>
+
+static void testPushPop()
+{
+    SpscRing<int, 4> ring;
+    int value = 0;
+    CHECK(ring.empty());
+    CHECK(!ring.pop(&value));
+
+    for (int i = 0; i < 4; ++i)
+        CHECK(ring.push(i));
+    CHECK_EQUAL(ring.size(), 4u);
+    // full, the value is dropped
+    CHECK(!ring.push(4));
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK(ring.pop(&value));
+        CHECK_EQUAL(value, i);
+    }
+    CHECK(ring.empty());
+    CHECK(!ring.pop(&value));
+}
+
+static void testWrapAround()
+{
+    // indices pass the capacity many times, order is kept
+    SpscRing<int, 8> ring;
+    int next_push = 0;
+    int next_pop = 0;
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 5; ++i)
+            CHECK(ring.push(next_push++));
+        for (int i = 0; i < 5; ++i) {
+            int value = -1;
+            CHECK(ring.pop(&value));
+            CHECK_EQUAL(value, next_pop++);
+        }
+    }
+    CHECK(ring.empty());
+}
+
+static void testWasEmpty()
+{
+    SpscRing<int, 4> ring;
+    bool was_empty = false;
+
+    // only the first value of a batch wakes the consumer
+    CHECK(ring.push(1, &was_empty));
+    CHECK(was_empty);
+    CHECK(ring.push(2, &was_empty));
+    CHECK(!was_empty);
+
+    int value = 0;
+    CHECK(ring.pop(&value));
+    CHECK(ring.push(3, &was_empty));
+    CHECK(!was_empty);
+
+    CHECK(ring.pop(&value));
+    CHECK(ring.pop(&value));
+    CHECK(ring.push(4, &was_empty));
+    CHECK(was_empty);
+}
+
+// a consumer that waits whenever the ring is empty must be woken for every batch,
+// a value found only after the producer is done was pushed without a wake up
+static void testProducerConsumer()
+{
+    constexpr int kCount = 200000;
+    SpscRing<int, 64> ring;
+    std::atomic<int> wakes = { 0 };
+    std::atomic<bool> done = { false };
+    int received = 0;
+    bool ordered = true;
+    bool missed_wake = false;
+
+    std::thread consumer([&]() {
+        int value = 0;
+        while (true) {
+            const int seen_wakes = wakes.load();
+            if (ring.pop(&value)) {
+                ordered &= value == received++;
+                continue;
+            }
+            while (wakes.load() == seen_wakes && !done.load())
+                std::this_thread::yield();
+            if (wakes.load() == seen_wakes) {
+                missed_wake = !ring.empty();
+                while (ring.pop(&value))
+                    ordered &= value == received++;
+                return;
+            }
+        }
+    });
+
+    for (int i = 0; i < kCount; ++i) {
+        bool was_empty = false;
+        while (!ring.push(i, &was_empty))
+            std::this_thread::yield();
+        if (was_empty)
+            ++wakes;
+    }
+    done = true;
+    consumer.join();
+
+    CHECK_EQUAL(received, kCount);
+    CHECK(ordered);
+    CHECK(!missed_wake);
+}
+
+int main()
+{
+    testPushPop();
+    testWrapAround();
+    testWasEmpty();
+    testProducerConsumer();
+    return test::finish("SpscRingTest");
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdio>
+
+// minimal checks for the portable utils, a test program returns the number of failures
+namespace test {
+
+inline int &failures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline int finish(const char *name)
+{
+    if (failures() == 0)
+        std::printf("%s: passed\n", name);
+    else
+        std::printf("%s: %d failed\n", name, failures());
+    return failures() == 0 ? 0 : 1;
+}
+
+}  // namespace test
+
+#define CHECK(expr) \
+    do { \
+        if (!(expr)) { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+            ++test::failures(); \
+        } \
+    } while (false)
+
+#define CHECK_EQUAL(a, b) CHECK((a) == (b))
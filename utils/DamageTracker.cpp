@@ -0,0 +1,179 @@
+#include "DamageTracker.h"
+
+#include <limits>
+
+static int minInt(int a, int b) { return a < b ? a : b; }
+static int maxInt(int a, int b) { return a > b ? a : b; }
+
+bool DamageRect::intersects(const DamageRect &other) const
+{
+    return left < other.right && other.left < right
+            && top < other.bottom && other.top < bottom;
+}
+
+bool DamageRect::contains(const DamageRect &other) const
+{
+    return left <= other.left && top <= other.top
+            && right >= other.right && bottom >= other.bottom;
+}
+
+DamageRect DamageRect::united(const DamageRect &other) const
+{
+    if (empty())
+        return other;
+    if (other.empty())
+        return *this;
+    return {
+        minInt(left, other.left), minInt(top, other.top),
+        maxInt(right, other.right), maxInt(bottom, other.bottom)
+    };
+}
+
+DamageRect DamageRect::intersected(const DamageRect &other) const
+{
+    DamageRect rect = {
+        maxInt(left, other.left), maxInt(top, other.top),
+        minInt(right, other.right), minInt(bottom, other.bottom)
+    };
+    return rect.empty() ? DamageRect() : rect;
+}
+
+void DamageRect::offset(int dx, int dy)
+{
+    left += dx;
+    right += dx;
+    top += dy;
+    bottom += dy;
+}
+
+bool DamageRect::operator==(const DamageRect &other) const
+{
+    return left == other.left && top == other.top
+            && right == other.right && bottom == other.bottom;
+}
+
+DamageRect DamageTracker::bounds() const
+{
+    if (m_infinite) {
+        return {
+            std::numeric_limits<int>::min(), std::numeric_limits<int>::min(),
+            std::numeric_limits<int>::max(), std::numeric_limits<int>::max()
+        };
+    }
+
+    DamageRect rect;
+    for (const auto &damage : *this)
+        rect = rect.united(damage);
+    return rect;
+}
+
+bool DamageTracker::intersects(const DamageRect &rect) const
+{
+    if (rect.empty())
+        return false;
+    if (m_infinite)
+        return true;
+
+    for (const auto &damage : *this) {
+        if (damage.intersects(rect))
+            return true;
+    }
+    return false;
+}
+
+void DamageTracker::add(DamageRect rect)
+{
+    if (m_infinite || rect.empty())
+        return;
+
+    size_t i = 0;
+    while (i < m_count) {
+        const DamageRect &damage = m_rects[i];
+        if (damage.contains(rect))
+            return;
+
+        // merge when the union costs no more than drawing both rects
+        const DamageRect united = damage.united(rect);
+        if (rect.contains(damage) || united.area() <= damage.area() + rect.area()) {
+            rect = united;
+            removeAt(i);
+            // the united rect may swallow rects already checked
+            i = 0;
+            continue;
+        }
+        ++i;
+    }
+
+    if (m_count == kMaxRects)
+        mergeClosestPair();
+    m_rects[m_count++] = rect;
+}
+
+void DamageTracker::unite(const DamageTracker &other)
+{
+    if (other.m_infinite) {
+        makeInfinite();
+        return;
+    }
+    for (const auto &damage : other)
+        add(damage);
+}
+
+void DamageTracker::clip(const DamageRect &bounds)
+{
+    if (m_infinite) {
+        m_infinite = false;
+        m_count = 0;
+        add(bounds);
+        return;
+    }
+
+    size_t i = 0;
+    while (i < m_count) {
+        m_rects[i] = m_rects[i].intersected(bounds);
+        if (m_rects[i].empty()) {
+            removeAt(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void DamageTracker::makeInfinite()
+{
+    m_infinite = true;
+    m_count = 0;
+}
+
+void DamageTracker::clear()
+{
+    m_infinite = false;
+    m_count = 0;
+}
+
+void DamageTracker::removeAt(size_t index)
+{
+    m_rects[index] = m_rects[m_count - 1];
+    --m_count;
+}
+
+void DamageTracker::mergeClosestPair()
+{
+    // find the pair whose union wastes the least area
+    size_t first = 0, second = 1;
+    long long min_waste = std::numeric_limits<long long>::max();
+    for (size_t i = 0; i < m_count; ++i) {
+        for (size_t j = i + 1; j < m_count; ++j) {
+            const long long waste = m_rects[i].united(m_rects[j]).area()
+                    - m_rects[i].area() - m_rects[j].area();
+            if (waste < min_waste) {
+                min_waste = waste;
+                first = i;
+                second = j;
+            }
+        }
+    }
+
+    m_rects[first] = m_rects[first].united(m_rects[second]);
+    removeAt(second);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+// integer rectangle, right and bottom are exclusive
+struct DamageRect
+{
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+
+    int width() const { return right - left; }
+    int height() const { return bottom - top; }
+    long long area() const { return empty() ? 0 : static_cast<long long>(width()) * height(); }
+    bool empty() const { return right <= left || bottom <= top; }
+
+    bool intersects(const DamageRect &other) const;
+    bool contains(const DamageRect &other) const;
+    DamageRect united(const DamageRect &other) const;
+    DamageRect intersected(const DamageRect &other) const;
+    void offset(int dx, int dy);
+
+    bool operator==(const DamageRect &other) const;
+    bool operator!=(const DamageRect &other) const { return !(*this == other); }
+};
+
+// a small list of damaged rectangles, overlapping or nearby rectangles are coalesced
+// so that redraw only touches a few rectangles instead of a whole region
+class DamageTracker
+{
+public:
+    static constexpr size_t kMaxRects = 8;
+
+    using RectArray = std::array<DamageRect, kMaxRects>;
+
+    bool empty() const { return !m_infinite && m_count == 0; }
+    bool infinite() const { return m_infinite; }
+    size_t size() const { return m_count; }
+    RectArray::const_iterator begin() const { return m_rects.begin(); }
+    RectArray::const_iterator end() const { return m_rects.begin() + m_count; }
+
+    DamageRect bounds() const;
+    bool intersects(const DamageRect &rect) const;
+
+    void add(DamageRect rect);
+    void unite(const DamageTracker &other);
+    // limit damage to bounds, infinite damage becomes bounds
+    void clip(const DamageRect &bounds);
+    void makeInfinite();
+    void clear();
+
+private:
+    void removeAt(size_t index);
+    void mergeClosestPair();
+
+    RectArray m_rects;
+    size_t m_count = 0;
+    bool m_infinite = false;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// window and id notified by a hotkey, target is a window handle, 0 for a free slot and
+// HotkeyTable::kClaimedTarget while a registration writes the id
+struct HotkeySlot
+{
+    uint64_t target;
+    int32_t id;
+    uint32_t reserved;
+};
+
+// hotkey pressed, queued by the hook with the time its key event arrived
+struct HotkeyEvent
+{
+    int32_t id;
+    uint64_t time;  // microseconds of the performance counter
+};
+
+// liveness of the hook, filled on the thread that installed it
+struct HookHealth
+{
+    static constexpr size_t kRecentCount = 16;
+
+    uint64_t calls;  // keys seen by the hook
+    uint64_t last_call_time;  // microseconds of the performance counter
+    uint32_t recent_times[kRecentCount];  // microseconds spent per key, oldest first
+};
+
+// every combination of modifier bits (SHIFT | CTRL | ALT) and virtual key has its own
+// slot, so finding a hotkey is one indexed load without hashing or allocation.
+// plain data of fixed layout, shared between processes through a file mapping
+struct HotkeyTable
+{
+    static constexpr size_t kModifierCount = 8;
+    static constexpr size_t kKeyCount = 256;
+    static constexpr size_t kModUpTargetCount = 4;
+    // target of a slot claimed by a registration that has not written its id yet,
+    // the value of HWND_TOPMOST is never a window
+    static constexpr uint64_t kClaimedTarget = ~static_cast<uint64_t>(0);
+
+    static constexpr bool validHotkey(size_t modifiers, size_t key)
+    {
+        return modifiers < kModifierCount && key < kKeyCount;
+    }
+    // single modifier bit
+    static constexpr bool validModifier(size_t modifier)
+    {
+        return modifier != 0 && modifier < kModifierCount && (modifier & (modifier - 1)) == 0;
+    }
+
+    HotkeySlot hotkeys[kModifierCount][kKeyCount];
+    // windows notified once when a modifier is released, indexed by modifier bit
+    uint64_t mod_up_targets[kModifierCount][kModUpTargetCount];
+};
+
+// std::is_pod is deprecated since C++20, its two parts are what the shared memory needs
+static_assert(std::is_trivially_copyable<HotkeySlot>::value && std::is_standard_layout<HotkeySlot>::value
+        && std::is_trivially_copyable<HotkeyTable>::value && std::is_standard_layout<HotkeyTable>::value,
+        "hotkey table is zero initialized and shared as raw memory");
+static_assert(sizeof(HotkeySlot) == 16, "slot layout must not depend on the compiler");
+static_assert(offsetof(HotkeyTable, mod_up_targets)
+        == sizeof(HotkeySlot) * HotkeyTable::kModifierCount * HotkeyTable::kKeyCount,
+        "hotkey slots must be packed");
+static_assert(sizeof(HotkeyTable) == offsetof(HotkeyTable, mod_up_targets)
+        + sizeof(uint64_t) * HotkeyTable::kModifierCount * HotkeyTable::kModUpTargetCount,
+        "table must not be padded");
+static_assert(HotkeyTable::validModifier(1) && HotkeyTable::validModifier(4)
+        && !HotkeyTable::validModifier(3) && !HotkeyTable::validModifier(8),
+        "modifiers are single bits of SHIFT | CTRL | ALT");
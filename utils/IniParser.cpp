@@ -0,0 +1,338 @@
+#include "IniParser.h"
+
+#include <cstring>
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static char upperCase(char c)
+{
+    return c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c;
+}
+
+static bool parseInteger(const char *begin, const char *end, long long *value)
+{
+    bool negative = false;
+    if (begin != end && (*begin == '+' || *begin == '-'))
+        negative = *begin++ == '-';
+    if (begin == end)
+        return false;
+
+    long long result = 0;
+    for (; begin != end; ++begin) {
+        if (*begin < '0' || *begin > '9')
+            return false;
+        // saturate, clamped to the range of the field later
+        if (result < 1000000000000000LL)
+            result = result * 10 + (*begin - '0');
+    }
+    *value = negative ? -result : result;
+    return true;
+}
+
+static bool parseDecimal(const char *begin, const char *end, double *value)
+{
+    bool negative = false;
+    if (begin != end && (*begin == '+' || *begin == '-'))
+        negative = *begin++ == '-';
+
+    double result = 0;
+    bool digits = false;
+    for (; begin != end && *begin >= '0' && *begin <= '9'; ++begin) {
+        result = result * 10 + (*begin - '0');
+        digits = true;
+    }
+    if (begin != end && *begin == '.') {
+        double scale = 0.1;
+        for (++begin; begin != end && *begin >= '0' && *begin <= '9'; ++begin) {
+            result += (*begin - '0') * scale;
+            scale *= 0.1;
+            digits = true;
+        }
+    }
+    if (!digits || begin != end)
+        return false;
+    *value = negative ? -result : result;
+    return true;
+}
+
+static double clampValue(double value, const IniField &field, bool *clamped)
+{
+    if (value < field.min_value) {
+        *clamped = true;
+        return field.min_value;
+    }
+    if (value > field.max_value) {
+        *clamped = true;
+        return field.max_value;
+    }
+    return value;
+}
+
+void IniParser::applyDefaults(void *settings) const
+{
+    for (size_t i = 0; i < m_schema.field_count; ++i) {
+        const IniField &field = m_schema.fields[i];
+        char *member = static_cast<char *>(settings) + field.offset;
+        std::memset(member, 0, field.size);
+
+        const char *value = field.default_value;
+        bool clamped = false;
+        if (*value)
+            writeValue(field, { value, value + std::strlen(value) }, settings, &clamped);
+    }
+}
+
+void IniParser::parse(const char *data, size_t size, void *settings,
+        std::vector<IniDiagnostic> *diagnostics) const
+{
+    auto report = [diagnostics](size_t line, const char *message, Span detail) {
+        if (!diagnostics)
+            return;
+        std::string text = message;
+        if (!detail.empty())
+            text.append(": ").append(detail.begin, detail.end);
+        diagnostics->push_back({ line, std::move(text) });
+    };
+
+    const char *pos = data;
+    const char *end = data + size;
+    // UTF-8 BOM
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+        pos += 3;
+
+    Span section = { nullptr, nullptr };
+    bool in_section = false;
+    bool section_known = false;
+    for (size_t line_number = 1; pos < end; ++line_number) {
+        const char *line_end = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (!line_end)
+            line_end = end;
+        const Span line = trimmed({ pos, line_end });
+        pos = line_end == end ? end : line_end + 1;
+
+        // ignore empty lines and comments
+        if (line.empty() || *line.begin == '#' || *line.begin == ';')
+            continue;
+
+        // group tag
+        if (*line.begin == '[') {
+            if (*(line.end - 1) != ']') {
+                report(line_number, "unclosed section", line);
+                in_section = section_known = false;
+                continue;
+            }
+            section = trimmed({ line.begin + 1, line.end - 1 });
+            in_section = true;
+            section_known = knownSection(section);
+            if (!section_known)
+                report(line_number, "unknown section", section);
+            continue;
+        }
+
+        const char *equal = static_cast<const char *>(std::memchr(line.begin, '=', line.size()));
+        if (!equal) {
+            report(line_number, "expected key=value", line);
+            continue;
+        }
+        const Span key = trimmed({ line.begin, equal });
+        const Span value = trimmed({ equal + 1, line.end });
+        if (!in_section) {
+            report(line_number, "key outside of a section", key);
+            continue;
+        }
+        // keys of unknown sections are reported with the section
+        if (!section_known)
+            continue;
+
+        const IniField *field = findField(section, key);
+        if (!field) {
+            report(line_number, "unknown key", key);
+            continue;
+        }
+        if (value.empty())
+            continue;
+
+        bool clamped = false;
+        const char *error = writeValue(*field, value, settings, &clamped);
+        if (error) {
+            report(line_number, error, value);
+        } else if (clamped) {
+            report(line_number, "value out of range, clamped", value);
+        }
+    }
+}
+
+unsigned int IniParser::changedTags(const void *a, const void *b) const
+{
+    unsigned int tags = 0;
+    for (size_t i = 0; i < m_schema.field_count; ++i) {
+        const IniField &field = m_schema.fields[i];
+        const char *member_a = static_cast<const char *>(a) + field.offset;
+        const char *member_b = static_cast<const char *>(b) + field.offset;
+        // bytes after the terminator are left from longer values
+        const bool same = field.type == IniType::String
+                ? std::strncmp(member_a, member_b, field.size) == 0
+                : std::memcmp(member_a, member_b, field.size) == 0;
+        if (!same)
+            tags |= field.tags;
+    }
+    return tags;
+}
+
+const IniField *IniParser::findField(Span section, Span key) const
+{
+    for (size_t i = 0; i < m_schema.field_count; ++i) {
+        const IniField &field = m_schema.fields[i];
+        if (equals(key, field.key) && equals(section, field.section))
+            return &field;
+    }
+    return nullptr;
+}
+
+bool IniParser::knownSection(Span section) const
+{
+    for (size_t i = 0; i < m_schema.field_count; ++i) {
+        if (equals(section, m_schema.fields[i].section))
+            return true;
+    }
+    return false;
+}
+
+bool IniParser::findName(const IniName *names, size_t count, Span name, unsigned int *code) const
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (equalsNoCase(name, names[i].name)) {
+            *code = names[i].code;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IniParser::parseKey(Span value, unsigned int *key) const
+{
+    // letters and digits are their own virtual keys
+    if (value.size() == 1) {
+        const char c = upperCase(*value.begin);
+        if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+            *key = c;
+            return true;
+        }
+    }
+    return findName(m_schema.keys, m_schema.key_count, value, key);
+}
+
+bool IniParser::parseHotkey(Span value, IniHotkey *hotkey) const
+{
+    IniHotkey result = { 0, 0 };
+    int modifier_count = 0;
+    const char *token_begin = value.begin;
+    while (true) {
+        const char *plus = static_cast<const char *>(
+                std::memchr(token_begin, '+', value.end - token_begin));
+        const Span token = trimmed({ token_begin, plus ? plus : value.end });
+        if (!plus) {
+            // last token is the key, at least one modifier before it
+            if (modifier_count == 0 || !parseKey(token, &result.second))
+                return false;
+            break;
+        }
+
+        unsigned int modifier = 0;
+        if (++modifier_count > 3 || !findName(m_schema.modifiers, m_schema.modifier_count,
+                token, &modifier))
+            return false;
+        result.first |= modifier;
+        token_begin = plus + 1;
+    }
+    *hotkey = result;
+    return true;
+}
+
+const char *IniParser::writeValue(const IniField &field, Span value, void *settings,
+        bool *clamped) const
+{
+    char *member = static_cast<char *>(settings) + field.offset;
+    switch (field.type) {
+    case IniType::Bool:
+        if (value.size() != 1 || (*value.begin != '0' && *value.begin != '1'))
+            return "expected 0 or 1";
+        *reinterpret_cast<bool *>(member) = *value.begin == '1';
+        return nullptr;
+
+    case IniType::Int:
+        {
+            long long number = 0;
+            if (!parseInteger(value.begin, value.end, &number))
+                return "expected an integer";
+            const double limited = clampValue(static_cast<double>(number), field, clamped);
+            const double int_min = std::numeric_limits<int>::min();
+            const double int_max = std::numeric_limits<int>::max();
+            *reinterpret_cast<int *>(member) = static_cast<int>(
+                    limited < int_min ? int_min : limited > int_max ? int_max : limited);
+        }
+        return nullptr;
+
+    case IniType::Float:
+        {
+            double number = 0;
+            if (!parseDecimal(value.begin, value.end, &number))
+                return "expected a number";
+            *reinterpret_cast<float *>(member) = static_cast<float>(clampValue(number, field, clamped));
+        }
+        return nullptr;
+
+    case IniType::Key:
+        {
+            unsigned int key = 0;
+            if (!equals(value, "0") && !parseKey(value, &key))
+                return "unknown key name";
+            *reinterpret_cast<unsigned int *>(member) = key;
+        }
+        return nullptr;
+
+    case IniType::Hotkey:
+        {
+            IniHotkey hotkey = { 0, 0 };
+            if (!equals(value, "0") && !parseHotkey(value, &hotkey))
+                return "expected MODIFIER+KEY";
+            *reinterpret_cast<IniHotkey *>(member) = hotkey;
+        }
+        return nullptr;
+
+    case IniType::String:
+        if (value.size() >= field.size)
+            return "string too long";
+        std::memcpy(member, value.begin, value.size());
+        member[value.size()] = '\0';
+        return nullptr;
+    }
+    return "unsupported type";
+}
+
+IniParser::Span IniParser::trimmed(Span span)
+{
+    while (span.begin != span.end && isSpace(*span.begin))
+        ++span.begin;
+    while (span.begin != span.end && isSpace(*(span.end - 1)))
+        --span.end;
+    return span;
+}
+
+bool IniParser::equals(Span span, const char *str)
+{
+    const size_t length = std::strlen(str);
+    return length == span.size() && std::memcmp(span.begin, str, length) == 0;
+}
+
+bool IniParser::equalsNoCase(Span span, const char *str)
+{
+    for (const char *c = span.begin; c != span.end; ++c, ++str) {
+        if (*str == '\0' || upperCase(*c) != upperCase(*str))
+            return false;
+    }
+    return *str == '\0';
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class IniType
+{
+    Bool,  // 0 or 1
+    Int,
+    Float,
+    Key,  // unsigned int virtual key, 0 means none
+    Hotkey,  // IniHotkey, MODIFIER+...+KEY, 0 means none
+    String  // char array of size, NUL terminated
+};
+
+// modifier bits and virtual key
+using IniHotkey = std::pair<unsigned int, unsigned int>;
+
+// a setting stored in plain data at offset. default is written like the value in the file,
+// numbers out of [min, max] are clamped
+struct IniField
+{
+    const char *section;  // without brackets
+    const char *key;
+    IniType type;
+    size_t offset;
+    size_t size;
+    const char *default_value;
+    double min_value;
+    double max_value;
+    unsigned int tags;  // bits of the application, e.g. what to refresh when it changes
+};
+
+constexpr double kIniNoMin = std::numeric_limits<double>::lowest();
+constexpr double kIniNoMax = std::numeric_limits<double>::max();
+
+// name of a key or a modifier in values, compared without case
+struct IniName
+{
+    const char *name;
+    unsigned int code;
+};
+
+struct IniSchema
+{
+    const IniField *fields;
+    size_t field_count;
+    const IniName *keys;
+    size_t key_count;
+    const IniName *modifiers;
+    size_t modifier_count;
+};
+
+struct IniDiagnostic
+{
+    size_t line;
+    std::string message;
+};
+
+// size of every field matches its type
+constexpr bool validIniSchema(const IniField *fields, size_t count, size_t settings_size)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const IniField &field = fields[i];
+        if (field.offset + field.size > settings_size || !field.default_value)
+            return false;
+        switch (field.type) {
+        case IniType::Bool:
+            if (field.size != sizeof(bool))
+                return false;
+            break;
+        case IniType::Int:
+            if (field.size != sizeof(int))
+                return false;
+            break;
+        case IniType::Float:
+            if (field.size != sizeof(float))
+                return false;
+            break;
+        case IniType::Key:
+            if (field.size != sizeof(unsigned int))
+                return false;
+            break;
+        case IniType::Hotkey:
+            if (field.size != sizeof(IniHotkey))
+                return false;
+            break;
+        case IniType::String:
+            if (field.size == 0)
+                return false;
+            break;
+        }
+    }
+    return true;
+}
+
+// single pass over a buffer of the file, settings are written through the schema without
+// allocation. only diagnostics allocate
+class IniParser
+{
+public:
+    explicit IniParser(const IniSchema &schema) : m_schema(schema) {}
+
+    void applyDefaults(void *settings) const;
+    // fields missing in buffer or with empty values keep their current value
+    void parse(const char *data, size_t size, void *settings,
+            std::vector<IniDiagnostic> *diagnostics) const;
+    // tags of fields whose values differ between two settings
+    unsigned int changedTags(const void *a, const void *b) const;
+
+private:
+    struct Span
+    {
+        const char *begin;
+        const char *end;
+
+        size_t size() const { return end - begin; }
+        bool empty() const { return begin == end; }
+    };
+
+    const IniField *findField(Span section, Span key) const;
+    bool knownSection(Span section) const;
+    bool findName(const IniName *names, size_t count, Span name, unsigned int *code) const;
+    bool parseKey(Span value, unsigned int *key) const;
+    bool parseHotkey(Span value, IniHotkey *hotkey) const;
+    // error message of a bad value, nullptr if written
+    const char *writeValue(const IniField &field, Span value, void *settings, bool *clamped) const;
+
+    static Span trimmed(Span span);
+    static bool equals(Span span, const char *str);
+    static bool equalsNoCase(Span span, const char *str);
+
+    IniSchema m_schema;
+};
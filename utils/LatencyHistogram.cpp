@@ -0,0 +1,102 @@
+#include "LatencyHistogram.h"
+
+static int highestBit(uint64_t value)
+{
+    int bit = 0;
+    while (value >>= 1)
+        ++bit;
+    return bit;
+}
+
+int LatencyHistogram::bucketIndex(uint64_t value)
+{
+    // values below 2 * kSubBucketCount are recorded exactly
+    if (value < 2 * kSubBucketCount)
+        return static_cast<int>(value);
+
+    int exponent = highestBit(value) - kSubBucketBits;
+    if (exponent > kMaxValueBits - kSubBucketBits - 1)
+        return kBucketCount - 1;
+    const int sub_bucket = static_cast<int>(value >> exponent) - kSubBucketCount;
+    return (exponent + 1) * kSubBucketCount + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(int index)
+{
+    if (index < 2 * kSubBucketCount)
+        return index;
+
+    const int exponent = index / kSubBucketCount - 1;
+    const uint64_t sub_bucket = index % kSubBucketCount + kSubBucketCount;
+    return sub_bucket << exponent;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < 2 * kSubBucketCount)
+        return index;
+
+    const int exponent = index / kSubBucketCount - 1;
+    const uint64_t sub_bucket = index % kSubBucketCount + kSubBucketCount;
+    return ((sub_bucket + 1) << exponent) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    // counters only, ordering between them does not matter
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current = m_min.load(std::memory_order_relaxed);
+    while (value < current
+            && !m_min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    current = m_max.load(std::memory_order_relaxed);
+    while (value > current
+            && !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(UINT64_MAX, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    const uint64_t samples = count();
+    if (samples == 0)
+        return 0.0;
+    return static_cast<double>(m_sum.load(std::memory_order_relaxed)) / samples;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const
+{
+    // buckets may be ahead of count while recording, count of buckets is used instead
+    uint64_t samples = 0;
+    for (const auto &bucket : m_buckets)
+        samples += bucket.load(std::memory_order_relaxed);
+    if (samples == 0)
+        return 0;
+
+    uint64_t target = static_cast<uint64_t>(percent / 100.0 * samples + 0.5);
+    if (target < 1)
+        target = 1;
+    if (target > samples)
+        target = samples;
+
+    const uint64_t max_value = maxValue();
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            const uint64_t value = bucketUpperBound(i);
+            return value < max_value ? value : max_value;
+        }
+    }
+    return max_value;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// log-linear histogram of microsecond samples, 32 sub-buckets per power of two
+// keeps about 3% precision from 1us up to hours with a fixed memory footprint.
+// record() is lock-free and may run on any thread, readers see each counter
+// consistently but not all counters of one sample at once
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+    static constexpr int kMaxValueBits = 40;
+    static constexpr int kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+
+    LatencyHistogram() { reset(); }
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void record(uint64_t value);
+    // not atomic against concurrent record()
+    void reset();
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t minValue() const { return count() ? m_min.load(std::memory_order_relaxed) : 0; }
+    uint64_t maxValue() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const;
+    // value at percentile (0~100), upper bound of its bucket
+    uint64_t percentile(double percent) const;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketLowerBound(int index);
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> m_buckets;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_min;
+    std::atomic<uint64_t> m_max;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// fixed capacity cache, the least recently used entry is dropped when full
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache
+{
+public:
+    explicit LruCache(size_t capacity) : m_capacity(capacity) {}
+
+    size_t size() const { return m_entries.size(); }
+    size_t capacity() const { return m_capacity; }
+    bool contains(const Key &key) const { return m_index.find(key) != m_index.end(); }
+
+    // return cached value and mark it as most recently used, nullptr if absent
+    Value *get(const Key &key)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+            return nullptr;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return &it->second->second;
+    }
+
+    void put(const Key &key, Value value)
+    {
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            it->second->second = std::move(value);
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return;
+        }
+
+        m_entries.emplace_front(key, std::move(value));
+        m_index.emplace(key, m_entries.begin());
+        while (m_entries.size() > m_capacity) {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+    }
+
+    // remove value from cache and return it
+    bool take(const Key &key, Value *value)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+            return false;
+        if (value)
+            *value = std::move(it->second->second);
+        m_entries.erase(it->second);
+        m_index.erase(it);
+        return true;
+    }
+
+    void erase(const Key &key) { take(key, nullptr); }
+
+    void clear()
+    {
+        m_index.clear();
+        m_entries.clear();
+    }
+
+    // visit entries from the most recently used
+    template <typename Function>
+    void forEach(Function function)
+    {
+        for (auto &entry : m_entries)
+            function(entry.first, entry.second);
+    }
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    size_t m_capacity;
+    std::list<Entry> m_entries;  // front is the most recently used
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> m_index;
+};
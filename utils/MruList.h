@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// keys ordered by their last use, touching and erasing a key are O(1)
+template <typename Key, typename Hash = std::hash<Key>>
+class MruList
+{
+public:
+    using const_iterator = typename std::list<Key>::const_iterator;
+
+    size_t size() const { return m_keys.size(); }
+    bool empty() const { return m_keys.empty(); }
+    bool contains(const Key &key) const { return m_index.find(key) != m_index.end(); }
+    // from the most recently used
+    const_iterator begin() const { return m_keys.begin(); }
+    const_iterator end() const { return m_keys.end(); }
+
+    // mark key as the most recently used, inserted if absent
+    void touch(const Key &key)
+    {
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_keys.splice(m_keys.begin(), m_keys, it->second);
+            return;
+        }
+        m_keys.push_front(key);
+        m_index.emplace(key, m_keys.begin());
+    }
+
+    void erase(const Key &key)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+            return;
+        m_keys.erase(it->second);
+        m_index.erase(it);
+    }
+
+    void clear()
+    {
+        m_index.clear();
+        m_keys.clear();
+    }
+
+    // move items used recently to the front in the order of use, the others keep their
+    // order after them. keys without an item are erased if closed(key) holds
+    template <typename Item, typename KeyOf, typename Closed>
+    void order(std::vector<Item> *items, KeyOf key_of, Closed closed)
+    {
+        std::unordered_map<Key, size_t, Hash> positions;
+        for (size_t i = 0; i < items->size(); ++i)
+            positions.emplace(key_of((*items)[i]), i);
+
+        std::vector<Item> ordered;
+        ordered.reserve(items->size());
+        std::vector<bool> taken(items->size(), false);
+        for (auto key_it = m_keys.begin(); key_it != m_keys.end();) {
+            auto it = positions.find(*key_it);
+            if (it != positions.end()) {
+                ordered.push_back(std::move((*items)[it->second]));
+                taken[it->second] = true;
+            } else if (closed(*key_it)) {
+                m_index.erase(*key_it);
+                key_it = m_keys.erase(key_it);
+                continue;
+            }
+            ++key_it;
+        }
+
+        if (ordered.empty())
+            return;
+        for (size_t i = 0; i < items->size(); ++i) {
+            if (!taken[i])
+                ordered.push_back(std::move((*items)[i]));
+        }
+        items->swap(ordered);
+    }
+
+private:
+    std::list<Key> m_keys;  // front is the most recently used
+    std::unordered_map<Key, typename std::list<Key>::iterator, Hash> m_index;
+};
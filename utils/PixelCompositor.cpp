@@ -0,0 +1,285 @@
+#include "PixelCompositor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PIXEL_TARGET_AVX2
+#else
+#define PIXEL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define PIXEL_X86 0
+#endif
+
+using RowKernel = void (*)(uint32_t *row, int count, uint32_t color);
+
+static int minInt(int a, int b) { return a < b ? a : b; }
+static int maxInt(int a, int b) { return a > b ? a : b; }
+
+// x / 255 rounded, exact for x <= 255 * 255
+static inline uint32_t div255(uint32_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static void fillRowScalar(uint32_t *row, int count, uint32_t color)
+{
+    for (int i = 0; i < count; ++i)
+        row[i] = color;
+}
+
+static inline uint32_t blendPixel(uint32_t dst, uint32_t color, uint32_t inv_alpha)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t channel = ((color >> shift) & 0xFF) + div255(((dst >> shift) & 0xFF) * inv_alpha);
+        result |= (channel > 0xFF ? 0xFF : channel) << shift;
+    }
+    return result;
+}
+
+static void blendRowScalar(uint32_t *row, int count, uint32_t color)
+{
+    const uint32_t inv_alpha = 255 - (color >> 24);
+    for (int i = 0; i < count; ++i)
+        row[i] = blendPixel(row[i], color, inv_alpha);
+}
+
+#if PIXEL_X86
+static void fillRowSSE2(uint32_t *row, int count, uint32_t color)
+{
+    const __m128i value = _mm_set1_epi32(static_cast<int>(color));
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), value);
+    fillRowScalar(row + i, count - i, color);
+}
+
+// 16 bit lanes of x * inv_alpha / 255
+static inline __m128i scaleSSE2(__m128i x, __m128i inv_alpha, __m128i bias)
+{
+    x = _mm_add_epi16(_mm_mullo_epi16(x, inv_alpha), bias);
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static void blendRowSSE2(uint32_t *row, int count, uint32_t color)
+{
+    const uint32_t inv = 255 - (color >> 24);
+    if (inv == 0) {
+        fillRowSSE2(row, count, color);
+        return;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i src = _mm_set1_epi32(static_cast<int>(color));
+    const __m128i inv_alpha = _mm_set1_epi16(static_cast<short>(inv));
+    const __m128i bias = _mm_set1_epi16(128);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i *p = reinterpret_cast<__m128i *>(row + i);
+        const __m128i dst = _mm_loadu_si128(p);
+        const __m128i lo = scaleSSE2(_mm_unpacklo_epi8(dst, zero), inv_alpha, bias);
+        const __m128i hi = scaleSSE2(_mm_unpackhi_epi8(dst, zero), inv_alpha, bias);
+        _mm_storeu_si128(p, _mm_adds_epu8(src, _mm_packus_epi16(lo, hi)));
+    }
+    blendRowScalar(row + i, count - i, color);
+}
+
+PIXEL_TARGET_AVX2 static void fillRowAVX2(uint32_t *row, int count, uint32_t color)
+{
+    const __m256i value = _mm256_set1_epi32(static_cast<int>(color));
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(row + i), value);
+    fillRowScalar(row + i, count - i, color);
+}
+
+PIXEL_TARGET_AVX2 static inline __m256i scaleAVX2(__m256i x, __m256i inv_alpha, __m256i bias)
+{
+    x = _mm256_add_epi16(_mm256_mullo_epi16(x, inv_alpha), bias);
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+PIXEL_TARGET_AVX2 static void blendRowAVX2(uint32_t *row, int count, uint32_t color)
+{
+    const uint32_t inv = 255 - (color >> 24);
+    if (inv == 0) {
+        fillRowAVX2(row, count, color);
+        return;
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i src = _mm256_set1_epi32(static_cast<int>(color));
+    const __m256i inv_alpha = _mm256_set1_epi16(static_cast<short>(inv));
+    const __m256i bias = _mm256_set1_epi16(128);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i *p = reinterpret_cast<__m256i *>(row + i);
+        const __m256i dst = _mm256_loadu_si256(p);
+        // unpack and pack work in 128 bit lanes, the pixel order is kept
+        const __m256i lo = scaleAVX2(_mm256_unpacklo_epi8(dst, zero), inv_alpha, bias);
+        const __m256i hi = scaleAVX2(_mm256_unpackhi_epi8(dst, zero), inv_alpha, bias);
+        _mm256_storeu_si256(p, _mm256_adds_epu8(src, _mm256_packus_epi16(lo, hi)));
+    }
+    blendRowScalar(row + i, count - i, color);
+}
+
+static bool cpuSupportsSSE2()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool cpuSupportsAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    // the os must save ymm registers
+    const int osxsave_avx = (1 << 27) | (1 << 28);
+    if ((info[2] & osxsave_avx) != osxsave_avx || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+struct Kernels
+{
+    PixelCompositor::KernelSet set;
+    RowKernel fill_row;
+    RowKernel blend_row;
+};
+
+static Kernels kernelsFor(PixelCompositor::KernelSet set)
+{
+    switch (set) {
+#if PIXEL_X86
+    case PixelCompositor::KernelSet::AVX2:
+        return { set, fillRowAVX2, blendRowAVX2 };
+    case PixelCompositor::KernelSet::SSE2:
+        return { set, fillRowSSE2, blendRowSSE2 };
+#endif
+    default:
+        return { PixelCompositor::KernelSet::Scalar, fillRowScalar, blendRowScalar };
+    }
+}
+
+static Kernels &activeKernels()
+{
+    static Kernels kernels = kernelsFor(
+            PixelCompositor::supported(PixelCompositor::KernelSet::AVX2)
+            ? PixelCompositor::KernelSet::AVX2
+            : PixelCompositor::supported(PixelCompositor::KernelSet::SSE2)
+            ? PixelCompositor::KernelSet::SSE2
+            : PixelCompositor::KernelSet::Scalar);
+    return kernels;
+}
+
+static void applyRows(const PixelSurface &surface, int left, int top, int right, int bottom,
+        uint32_t color, RowKernel kernel)
+{
+    if (!surface.valid())
+        return;
+
+    left = maxInt(left, 0);
+    top = maxInt(top, 0);
+    right = minInt(right, surface.width);
+    bottom = minInt(bottom, surface.height);
+    if (right <= left || bottom <= top)
+        return;
+
+    uint32_t *row = surface.pixels + static_cast<ptrdiff_t>(top) * surface.stride + left;
+    for (int y = top; y < bottom; ++y, row += surface.stride)
+        kernel(row, right - left, color);
+}
+
+PixelCompositor::KernelSet PixelCompositor::kernelSet()
+{
+    return activeKernels().set;
+}
+
+bool PixelCompositor::supported(KernelSet set)
+{
+    switch (set) {
+#if PIXEL_X86
+    case KernelSet::AVX2:
+        return cpuSupportsAVX2();
+    case KernelSet::SSE2:
+        return cpuSupportsSSE2();
+#endif
+    case KernelSet::Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool PixelCompositor::setKernelSet(KernelSet set)
+{
+    if (!supported(set))
+        return false;
+    activeKernels() = kernelsFor(set);
+    return true;
+}
+
+uint32_t PixelCompositor::premultiply(uint32_t argb)
+{
+    const uint32_t alpha = argb >> 24;
+    if (alpha == 255)
+        return argb;
+
+    uint32_t result = alpha << 24;
+    for (int shift = 0; shift < 24; shift += 8)
+        result |= div255(((argb >> shift) & 0xFF) * alpha) << shift;
+    return result;
+}
+
+void PixelCompositor::fill(const PixelSurface &surface, int left, int top, int right, int bottom,
+        uint32_t color)
+{
+    applyRows(surface, left, top, right, bottom, color, activeKernels().fill_row);
+}
+
+void PixelCompositor::blend(const PixelSurface &surface, int left, int top, int right, int bottom,
+        uint32_t color)
+{
+    if ((color >> 24) == 0)
+        return;
+    applyRows(surface, left, top, right, bottom, color, activeKernels().blend_row);
+}
+
+void PixelCompositor::stroke(const PixelSurface &surface, int left, int top, int right, int bottom,
+        int width, uint32_t color)
+{
+    if (width <= 0 || right <= left || bottom <= top)
+        return;
+
+    // frame is thicker than rect, fill it all
+    if (width * 2 >= right - left || width * 2 >= bottom - top) {
+        blend(surface, left, top, right, bottom, color);
+        return;
+    }
+
+    // top, bottom, then the sides between them so no pixel is blended twice
+    blend(surface, left, top, right, top + width, color);
+    blend(surface, left, bottom - width, right, bottom, color);
+    blend(surface, left, top + width, left + width, bottom - width, color);
+    blend(surface, right - width, top + width, right, bottom - width, color);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+// view of 32 bit premultiplied BGRA pixels in top-down rows
+struct PixelSurface
+{
+    uint32_t *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;  // in pixels
+
+    bool valid() const { return pixels && width > 0 && height > 0; }
+};
+
+// fills, blends and frames written directly into a pixel surface with vectorized
+// row kernels. the best kernel set supported by the cpu is used
+class PixelCompositor
+{
+public:
+    enum class KernelSet
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    static KernelSet kernelSet();
+    static bool supported(KernelSet set);
+    // force a kernel set, e.g. to compare with the scalar baseline
+    static bool setKernelSet(KernelSet set);
+
+    // straight ARGB to premultiplied ARGB
+    static uint32_t premultiply(uint32_t argb);
+
+    // rect is clipped to surface, right and bottom are exclusive. colors are premultiplied
+    static void fill(const PixelSurface &surface, int left, int top, int right, int bottom,
+            uint32_t color);
+    // source over
+    static void blend(const PixelSurface &surface, int left, int top, int right, int bottom,
+            uint32_t color);
+    // frame of width pixels inside rect, source over
+    static void stroke(const PixelSurface &surface, int left, int top, int right, int bottom,
+            int width, uint32_t color);
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+// bounded lock-free queue between one producer thread and one consumer thread.
+// push() tells whether the consumer may have found the ring empty, so the producer
+// wakes the consumer only for the first event of a batch
+template<typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+            "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "slots are copied without locking");
+
+public:
+    static constexpr size_t kCapacity = Capacity;
+
+    // producer side, fails when full. was_empty is set if the consumer had taken
+    // every earlier value, it may be waiting and needs a wake up
+    bool push(const T &value, bool *was_empty = nullptr)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head_cache == Capacity) {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+            if (tail - m_head_cache == Capacity)
+                return false;
+        }
+
+        m_slots[tail & (Capacity - 1)] = value;
+        // ordered with pop(), either the consumer sees the new tail or we see its head
+        m_tail.store(tail + 1, std::memory_order_seq_cst);
+        if (was_empty)
+            *was_empty = m_head.load(std::memory_order_seq_cst) == tail;
+        return true;
+    }
+
+    // consumer side, fails when empty
+    bool pop(T *value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail_cache) {
+            m_tail_cache = m_tail.load(std::memory_order_seq_cst);
+            if (head == m_tail_cache)
+                return false;
+        }
+
+        *value = m_slots[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // approximate unless called by the producer or the consumer while the other is idle
+    size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+
+private:
+    // indices only grow, slots are indexed modulo capacity
+    alignas(64) std::atomic<size_t> m_head = { 0 };
+    size_t m_tail_cache = 0;  // last tail seen by the consumer
+    alignas(64) std::atomic<size_t> m_tail = { 0 };
+    size_t m_head_cache = 0;  // last head seen by the producer
+    alignas(64) T m_slots[Capacity];
+};